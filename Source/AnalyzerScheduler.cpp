@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    AnalyzerScheduler.cpp
+
+  ==============================================================================
+*/
+
+#include "AnalyzerScheduler.h"
+
+AnalyzerScheduler::Worker::Worker(AnalyzerScheduler& owner, int index) :
+    juce::Thread("Analyzer " + juce::String(index)),
+    scheduler(owner)
+{
+}
+
+void AnalyzerScheduler::Worker::run()
+{
+    while (!threadShouldExit())
+    {
+        const auto interval = tickIntervalMs;
+        const auto budget = interval * cpuBudget / (double)scheduler.workers.size();
+
+        scheduler.runPass(budget);
+
+        //sleep until the next tick starts, all workers wake up together
+        const auto now = juce::Time::getMillisecondCounterHiRes();
+        const auto untilNextTick = interval - std::fmod(now, interval);
+        wait(juce::jmax(1, juce::roundToInt(untilNextTick)));
+    }
+}
+
+AnalyzerScheduler::AnalyzerScheduler()
+{
+    //leave at least one core to the audio and message threads
+    const auto numWorkers = juce::jlimit(1, maxWorkers, juce::SystemStats::getNumCpus() - 2);
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers.push_back(std::make_unique<Worker>(*this, i));
+
+    //a notch below normal, the analyzers are the first thing that may lag behind
+    for (auto& worker : workers)
+        worker->startThread(4);
+}
+
+AnalyzerScheduler::~AnalyzerScheduler()
+{
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (auto& worker : workers)
+    {
+        worker->notify();
+        worker->stopThread(1000);
+    }
+}
+
+void AnalyzerScheduler::addClient(Client* client)
+{
+    const juce::ScopedLock sl(clientLock);
+
+    if (std::find(clients.begin(), clients.end(), client) == clients.end())
+        clients.push_back(client);
+}
+
+void AnalyzerScheduler::removeClient(Client* client)
+{
+    {
+        const juce::ScopedLock sl(clientLock);
+        clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+    }
+
+    //clients are only claimed under the lock, so nobody can start it from here on.
+    //a signal left over from another frame only makes this check once more.
+    while (client->running.load())
+        frameFinished.wait(-1);
+}
+
+juce::int64 AnalyzerScheduler::getCurrentTick() const
+{
+    return (juce::int64)(juce::Time::getMillisecondCounterHiRes() / tickIntervalMs);
+}
+
+AnalyzerScheduler::Client* AnalyzerScheduler::claimNextClient(juce::int64 tick)
+{
+    const juce::ScopedLock sl(clientLock);
+
+    //the cursor carries over between ticks, so clients skipped for lack of budget come first next time
+    for (size_t i = 0; i < clients.size(); ++i)
+    {
+        auto* client = clients[nextClient % clients.size()];
+        nextClient = (nextClient + 1) % clients.size();
+
+        if (client->lastTick != tick && !client->running.load())
+        {
+            client->running.store(true);
+            client->lastTick = tick;
+            return client;
+        }
+    }
+
+    return nullptr;
+}
+
+void AnalyzerScheduler::runPass(double budgetMs)
+{
+    const auto tick = getCurrentTick();
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+
+    //a frame that starts inside the budget is finished, so a pass may overrun by one frame
+    while (juce::Time::getMillisecondCounterHiRes() - start < budgetMs)
+    {
+        auto* client = claimNextClient(tick);
+
+        if (client == nullptr)
+            return;
+
+        client->runAnalysis();
+        client->running.store(false);
+        frameFinished.signal();
+    }
+}
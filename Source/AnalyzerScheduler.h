@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    AnalyzerScheduler.h
+
+    One small pool of worker threads that runs the analyzer of every open
+    editor in the process, and every plugin's history analyzer, instead of
+    a thread and timer per editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ runs every registered analyzer once per tick (one display frame) on a fixed pool of workers.
+ each worker gets a slice of every tick to spend. clients are served round-robin and whoever
+ doesn't fit into this tick's budget goes first on the next one, so the analyzers' total CPU
+ use stays the same however many editors are open, and they just update less often instead.
+ share it through juce::SharedResourcePointer<AnalyzerScheduler>.
+ */
+struct AnalyzerScheduler
+{
+    struct Client
+    {
+        virtual ~Client() = default;
+
+        //one analysis frame. runs on a worker, never on two at once for the same client.
+        virtual void runAnalysis() = 0;
+    private:
+        friend struct AnalyzerScheduler;
+        std::atomic<bool> running { false };
+        juce::int64 lastTick = -1;
+    };
+
+    AnalyzerScheduler();
+    ~AnalyzerScheduler();
+
+    void addClient(Client* client);
+
+    /**
+     if the client is running right now, this waits for it to finish. message thread only.
+     */
+    void removeClient(Client* client);
+private:
+    struct Worker : juce::Thread
+    {
+        Worker(AnalyzerScheduler& owner, int index);
+        void run() override;
+
+        AnalyzerScheduler& scheduler;
+    };
+
+    //a few workers at most, the analyzers aren't worth more than that
+    static constexpr int maxWorkers = 2;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    //every client gets at most one frame per tick, one display frame
+    static constexpr double tickIntervalMs = 1000.0 / 60.0;
+    //fraction of one core all analyzers together may use, split evenly between the workers
+    static constexpr double cpuBudget = 0.25;
+
+    //signalled after every frame, for removeClient() to wait on. it's ours rather than the client's,
+    //since the client may be gone as soon as it's seen not running
+    juce::WaitableEvent frameFinished;
+
+    juce::CriticalSection clientLock;
+    std::vector<Client*> clients;
+    size_t nextClient = 0;
+
+    juce::int64 getCurrentTick() const;
+    //the next client that hasn't had its frame this tick and isn't running, marked as running
+    Client* claimNextClient(juce::int64 tick);
+    void runPass(double budgetMs);
+};
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    AnalyzerSettings.cpp
+
+  ==============================================================================
+*/
+
+#include "AnalyzerSettings.h"
+
+const AnalyzerSettings::Info& AnalyzerSettings::getInfo(Setting setting)
+{
+    //the names are the ids these had as host parameters, which loadFromState() relies on
+    static const std::array<Info, numSettings> infos
+    { {
+        { "Analyzer Resolution", { "2048", "4096", "8192" }, 0 },
+        { "Analyzer Mode", { "Raw", "Average", "Peak Hold", "Max Hold" }, 1 },
+        { "Analyzer Multi-Resolution", { "Off", "On" }, 0 },
+        { "Analyzer Smoothing", { "Off", "1/3 Oct", "1/6 Oct", "1/12 Oct", "1/24 Oct" }, 0 },
+        { "Analyzer View", { "Spectrum", "Spectrogram", "History" }, 0 },
+        { "Analyzer History", { "1 min", "10 min", "1 h", "6 h", "24 h" }, 1 },
+        { "Analyzer Pre-EQ", { "Off", "On" }, 0 },
+        //named like the host parameter it replaces, so loadFromState() picks up its old value
+        { "True Peak", { "Off", "On" }, 0 },
+    } };
+
+    return infos[setting];
+}
+
+AnalyzerSettings::AnalyzerSettings(juce::ValueTree& stateToUse) :
+    state(stateToUse)
+{
+    for (int i = 0; i < numSettings; ++i)
+        values[i].store(getInfo(static_cast<Setting>(i)).defaultIndex);
+}
+
+void AnalyzerSettings::set(Setting setting, int choiceIndex)
+{
+    const auto& info = getInfo(setting);
+    const auto index = juce::jlimit(0, info.choices.size() - 1, choiceIndex);
+
+    values[setting].store(index);
+    state.setProperty(juce::Identifier(info.name.removeCharacters(" -")), index, nullptr);
+}
+
+void AnalyzerSettings::loadFromState()
+{
+    for (int i = 0; i < numSettings; ++i)
+    {
+        const auto setting = static_cast<Setting>(i);
+        const auto& info = getInfo(setting);
+        const juce::Identifier property(info.name.removeCharacters(" -"));
+
+        int index = info.defaultIndex;
+
+        if (state.hasProperty(property))
+        {
+            index = (int)state.getProperty(property);
+        }
+        else
+        {
+            //saved while this was still a host parameter: <PARAM id="Analyzer Mode" value="1.0"/>
+            const auto parameter = state.getChildWithProperty("id", info.name);
+
+            if (parameter.isValid())
+                index = juce::roundToInt((float)parameter.getProperty("value"));
+        }
+
+        values[i].store(juce::jlimit(0, info.choices.size() - 1, index));
+    }
+}
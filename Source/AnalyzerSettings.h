@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    AnalyzerSettings.h
+
+    The analyzer's and the meter's display options. They only change what the
+    editor shows, so they're kept with the plugin's state instead of being host
+    parameters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ every option is a choice index, saved as a property of the APVTS state tree, so it travels
+ with the session and presets but never shows up in the host's automation lanes.
+ the analyzer workers and the audio thread read the atomics, the message thread changes them through set().
+ */
+struct AnalyzerSettings
+{
+    enum Setting
+    {
+        resolution,         //2048, 4096, 8192
+        mode,               //AnalyzerMode
+        multiResolution,    //off, on
+        smoothing,          //off, 1/3, 1/6, 1/12, 1/24 octave
+        view,               //AnalyzerView
+        historySpan,        //1 min, 10 min, 1 h, 6 h, 24 h
+        preEQ,              //off, on
+        truePeak,           //off, on. the audio thread only oversamples for the meter while it's on
+        numSettings
+    };
+
+    struct Info
+    {
+        juce::String name;
+        juce::StringArray choices;
+        int defaultIndex;
+    };
+
+    static const Info& getInfo(Setting setting);
+
+    explicit AnalyzerSettings(juce::ValueTree& stateToUse);
+
+    int get(Setting setting) const { return values[setting].load(); }
+    bool isOn(Setting setting) const { return get(setting) != 0; }
+
+    //message thread. out of range indices are clamped.
+    void set(Setting setting, int choiceIndex);
+
+    /**
+     message thread, after the state tree was replaced. options missing from it get their defaults,
+     or the value of the host parameter they used to be, so older sessions keep their analyzer setup.
+     */
+    void loadFromState();
+private:
+    juce::ValueTree& state;
+    std::array<std::atomic<int>, numSettings> values;
+};
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    AnalyzerTables.cpp
+
+  ==============================================================================
+*/
+
+#include "AnalyzerTables.h"
+
+AnalyzerTables::AnalyzerTables(int tableOrder, WindowingMethod windowingMethod) :
+    order(tableOrder),
+    window(windowingMethod),
+    windowTable(makeWindowTable(tableOrder, windowingMethod))
+{
+}
+
+std::vector<float> AnalyzerTables::makeWindowTable(int order, WindowingMethod window)
+{
+    std::vector<float> table((size_t)1 << order);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(table.data(), table.size(), window);
+    return table;
+}
+
+AnalyzerTables::Ptr AnalyzerTables::get(int order, WindowingMethod window)
+{
+    //function statics, so the cache exists before the first plugin instance asks for it
+    static juce::CriticalSection lock;
+    static std::vector<Ptr> cache;
+
+    const juce::ScopedLock sl(lock);
+
+    //a reference count of 1 means only the cache itself still holds it
+    cache.erase(std::remove_if(cache.begin(), cache.end(), [](const Ptr& tables)
+    {
+        return tables->getReferenceCount() == 1;
+    }), cache.end());
+
+    for (auto& tables : cache)
+    {
+        if (tables->order == order && tables->window == window)
+            return tables;
+    }
+
+    cache.push_back(new AnalyzerTables(order, window));
+    return cache.back();
+}
@@ -0,0 +1,43 @@
+/*
+  ==============================================================================
+
+    AnalyzerTables.h
+
+    Read-only window tables, shared by every analyzer in the process
+    instead of being built again by each editor and band.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ the part of an FFT plan that never changes once built and is never written: its window table.
+ get() hands out the one instance per (order, window) in the process, so fifty open editors
+ with four bands each still build each size only once. entries nobody holds any more are dropped
+ on a later get().
+
+ the juce::dsp::FFT itself isn't shared: its fallback engine takes a lock in perform() to guard
+ its scratch, so analyzers on different workers would take turns. every plan keeps its own.
+ */
+struct AnalyzerTables : juce::ReferenceCountedObject
+{
+    using Ptr = juce::ReferenceCountedObjectPtr<AnalyzerTables>;
+    using WindowingMethod = juce::dsp::WindowingFunction<float>::WindowingMethod;
+
+    /**
+     thread safe, but builds the tables on a miss, so don't call it from the audio thread.
+     */
+    static Ptr get(int order, WindowingMethod window);
+
+    AnalyzerTables(int order, WindowingMethod window);
+
+    const int order;
+    const WindowingMethod window;
+
+    const std::vector<float> windowTable;
+private:
+    static std::vector<float> makeWindowTable(int order, WindowingMethod window);
+};
@@ -0,0 +1,243 @@
+/*
+  ==============================================================================
+
+    BatchEQ.cpp
+
+  ==============================================================================
+*/
+
+#include "BatchEQ.h"
+
+void BatchEQ::prepare(int newNumStreams, double newSampleRate, int maximumBlockSize)
+{
+    jassert(newNumStreams > 0);
+    jassert(newSampleRate > 0);
+
+    numStreams = newNumStreams;
+    sampleRate = newSampleRate;
+    maxBlockSize = maximumBlockSize;
+
+    const auto lanes = getNumLanes();
+    numGroups = (numStreams + lanes - 1) / lanes;
+
+    //every lane starts out as a pass-through stage (b0 = 1)
+    Stage passThrough;
+    passThrough.b0 = Vec::expand(1.f);
+    passThrough.b1 = Vec::expand(0.f);
+    passThrough.b2 = Vec::expand(0.f);
+    passThrough.a1 = Vec::expand(0.f);
+    passThrough.a2 = Vec::expand(0.f);
+
+    stages.assign(numGroups * NumStages, passThrough);
+    states.resize(numGroups * NumStages);
+    activeLanes.assign(numGroups * NumStages, 0);
+    streamStageActive.assign(numStreams * NumStages, false);
+
+    scratch.resize(maxBlockSize);
+
+    reset();
+}
+
+void BatchEQ::reset()
+{
+    for (auto& state : states)
+    {
+        state.s1 = Vec::expand(0.f);
+        state.s2 = Vec::expand(0.f);
+    }
+}
+
+void BatchEQ::setChainSettings(const std::vector<ChainSettings>& chainSettings)
+{
+    if ((int)chainSettings.size() != numStreams)
+    {
+        jassertfalse;
+        return;
+    }
+
+    for (int i = 0; i < numStreams; ++i)
+        setChainSettings(i, chainSettings[i]);
+}
+
+void BatchEQ::setChainSettings(int streamIndex, const ChainSettings& chainSettings)
+{
+    //also catches a call before prepare(), when there are no streams and no stages to write to
+    if (!juce::isPositiveAndBelow(streamIndex, numStreams))
+    {
+        jassertfalse;
+        return;
+    }
+
+    auto lowCutCoefficients = makeLowCutFilter(chainSettings, sampleRate);
+    auto peakCoefficients = makePeakFilter(chainSettings, sampleRate);
+    auto highCutCoefficients = makeHighCutFilter(chainSettings, sampleRate);
+
+    //same stage selection as updateCutFilter(): a slope of Slope_N uses stages 0..N
+    for (int i = 0; i < 4; ++i)
+    {
+        if (!chainSettings.lowCutBypassed && i <= chainSettings.lowCutSlope)
+            setStage(streamIndex, i, lowCutCoefficients[i]);
+        else
+            setStageBypassed(streamIndex, i);
+    }
+
+    if (!chainSettings.peakBypassed)
+        setStage(streamIndex, 4, peakCoefficients);
+    else
+        setStageBypassed(streamIndex, 4);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if (!chainSettings.highCutBypassed && i <= chainSettings.highCutSlope)
+            setStage(streamIndex, 5 + i, highCutCoefficients[i]);
+        else
+            setStageBypassed(streamIndex, 5 + i);
+    }
+}
+
+void BatchEQ::setStage(int streamIndex, int stageIndex, const Coefficients& coefficients)
+{
+    const auto lanes = getNumLanes();
+    const auto lane = (size_t)(streamIndex % lanes);
+    auto& stage = stages[(streamIndex / lanes) * NumStages + stageIndex];
+
+    const auto* c = coefficients->getRawCoefficients();
+
+    //first order sections are stored as { b0, b1, a1 }, biquads as { b0, b1, b2, a1, a2 }
+    if (coefficients->coefficients.size() == 3)
+    {
+        stage.b0.set(lane, c[0]);
+        stage.b1.set(lane, c[1]);
+        stage.b2.set(lane, 0.f);
+        stage.a1.set(lane, c[2]);
+        stage.a2.set(lane, 0.f);
+    }
+    else
+    {
+        jassert(coefficients->coefficients.size() == 5);
+
+        stage.b0.set(lane, c[0]);
+        stage.b1.set(lane, c[1]);
+        stage.b2.set(lane, c[2]);
+        stage.a1.set(lane, c[3]);
+        stage.a2.set(lane, c[4]);
+    }
+
+    setStageActive(streamIndex, stageIndex, true);
+}
+
+void BatchEQ::setStageBypassed(int streamIndex, int stageIndex)
+{
+    const auto lanes = getNumLanes();
+    const auto lane = (size_t)(streamIndex % lanes);
+    const auto index = (streamIndex / lanes) * NumStages + stageIndex;
+    auto& stage = stages[index];
+
+    stage.b0.set(lane, 1.f);
+    stage.b1.set(lane, 0.f);
+    stage.b2.set(lane, 0.f);
+    stage.a1.set(lane, 0.f);
+    stage.a2.set(lane, 0.f);
+
+    //a bypassed lane has to pass its input through untouched, so drop whatever is left in its state
+    auto& state = states[index];
+    state.s1.set(lane, 0.f);
+    state.s2.set(lane, 0.f);
+
+    setStageActive(streamIndex, stageIndex, false);
+}
+
+void BatchEQ::setStageActive(int streamIndex, int stageIndex, bool active)
+{
+    bool flag = streamStageActive[streamIndex * NumStages + stageIndex];
+    if (flag == active)
+        return;
+
+    streamStageActive[streamIndex * NumStages + stageIndex] = active;
+    activeLanes[(streamIndex / getNumLanes()) * NumStages + stageIndex] += active ? 1 : -1;
+}
+
+void BatchEQ::process(float* const* streams, int numSamples)
+{
+    if (maxBlockSize <= 0)
+        return;
+
+    //hosts embedding this don't necessarily set FTZ/DAZ
+    juce::ScopedNoDenormals noDenormals;
+
+    //the scratch block only holds maxBlockSize samples per lane, so longer blocks go through in pieces
+    for (int offset = 0; offset < numSamples; offset += maxBlockSize)
+        processChunk(streams, offset, juce::jmin(maxBlockSize, numSamples - offset));
+}
+
+void BatchEQ::processChunk(float* const* streams, int offset, int numSamples)
+{
+    const auto lanes = getNumLanes();
+
+    //the scratch block is read lane-by-lane as plain floats: sample i of lane l lives at [i * lanes + l]
+    auto* interleaved = reinterpret_cast<float*>(scratch.data());
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        const auto firstStream = group * lanes;
+        const auto numLanesUsed = juce::jmin(lanes, numStreams - firstStream);
+
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            if (lane < numLanesUsed)
+            {
+                const auto* src = streams[firstStream + lane] + offset;
+                for (int i = 0; i < numSamples; ++i)
+                    interleaved[i * lanes + lane] = src[i];
+            }
+            else
+            {
+                for (int i = 0; i < numSamples; ++i)
+                    interleaved[i * lanes + lane] = 0.f;
+            }
+        }
+
+        for (int s = 0; s < NumStages; ++s)
+        {
+            const auto index = group * NumStages + s;
+            if (activeLanes[index] == 0)
+                continue;
+
+            const auto& c = stages[index];
+            auto s1 = states[index].s1;
+            auto s2 = states[index].s2;
+
+            //transposed direct form II, same arithmetic and per-block snap to zero as juce::dsp::IIR::Filter
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto input = scratch[i];
+                auto output = (c.b0 * input) + s1;
+                s1 = (c.b1 * input) - (c.a1 * output) + s2;
+                s2 = (c.b2 * input) - (c.a2 * output);
+                scratch[i] = output;
+            }
+
+            snapToZero(s1);
+            snapToZero(s2);
+            states[index].s1 = s1;
+            states[index].s2 = s2;
+        }
+
+        for (int lane = 0; lane < numLanesUsed; ++lane)
+        {
+            auto* dst = streams[firstStream + lane] + offset;
+            for (int i = 0; i < numSamples; ++i)
+                dst[i] = interleaved[i * lanes + lane];
+        }
+    }
+}
+
+void BatchEQ::snapToZero(Vec& value)
+{
+    for (size_t lane = 0; lane < Vec::size(); ++lane)
+    {
+        auto laneValue = value.get(lane);
+        juce::dsp::util::snapToZero(laneValue);
+        value.set(lane, laneValue);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    BatchEQ.h
+
+    Runs the EQ chain over many independent mono streams at once.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+/**
+ processes N mono streams, each with its own ChainSettings.
+
+ coefficients and filter states are kept stream-major in SoA form: one
+ SIMDRegister holds the same biquad stage for Vec::size() neighbouring streams,
+ so a group of streams goes through the whole cascade in a single pass.
+ the coefficients come from makeLowCutFilter / makePeakFilter / makeHighCutFilter,
+ so every stream matches what a MonoChain with the same settings produces.
+ */
+struct BatchEQ
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    //4 low cut stages, the peak, 4 high cut stages. same order as MonoChain
+    static constexpr int NumStages = 9;
+
+    void prepare(int numStreams, double sampleRate, int maximumBlockSize);
+    void reset();
+
+    //ignored before prepare(), or for a stream (or number of streams) it wasn't prepared for
+    void setChainSettings(int streamIndex, const ChainSettings& chainSettings);
+    void setChainSettings(const std::vector<ChainSettings>& chainSettings);
+
+    /**
+     filters every stream in place. 'streams' holds getNumStreams() pointers
+     to 'numSamples' floats each. blocks longer than maximumBlockSize are split up.
+     */
+    void process(float* const* streams, int numSamples);
+
+    int getNumStreams() const { return numStreams; }
+    static constexpr int getNumLanes() { return (int)Vec::size(); }
+private:
+    struct Stage
+    {
+        Vec b0, b1, b2, a1, a2;
+    };
+
+    struct State
+    {
+        Vec s1, s2;
+    };
+
+    int numStreams = 0;
+    int numGroups = 0;
+    int maxBlockSize = 0;
+    double sampleRate = 44100.0;
+
+    //indexed [group * NumStages + stage]
+    std::vector<Stage> stages;
+    std::vector<State> states;
+
+    //number of lanes in a group that actually use a stage. a stage nobody uses is skipped.
+    std::vector<int> activeLanes;
+    //[stream * NumStages + stage]
+    std::vector<bool> streamStageActive;
+
+    //one interleaved block per group
+    std::vector<Vec> scratch;
+
+    //the actual work, for at most maxBlockSize samples starting at 'offset'
+    void processChunk(float* const* streams, int offset, int numSamples);
+
+    //juce::dsp::IIR::Filter::snapToZero() for every lane, so decaying tails don't go denormal
+    static void snapToZero(Vec& value);
+
+    void setStage(int streamIndex, int stageIndex, const Coefficients& coefficients);
+    void setStageBypassed(int streamIndex, int stageIndex);
+    void setStageActive(int streamIndex, int stageIndex, bool active);
+};
@@ -0,0 +1,320 @@
+/*
+  ==============================================================================
+
+    EQCore.cpp
+
+  ==============================================================================
+*/
+
+#include "EQCore.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace eqcore
+{
+
+namespace
+{
+    constexpr double pi = 3.141592653589793238;
+
+    //divides everything by a0, exactly like juce::dsp::IIR::Coefficients does
+    BiquadCoefficients normalise(float b0, float b1, float b2, float a0, float a1, float a2)
+    {
+        const auto a0Inv = a0 != 0.f ? 1.f / a0 : 0.f;
+        return { b0 * a0Inv, b1 * a0Inv, b2 * a0Inv, a1 * a0Inv, a2 * a0Inv };
+    }
+
+    BiquadCoefficients makeLowPass(double sampleRate, float frequency, float Q)
+    {
+        const auto n = 1.f / std::tan(float(pi) * frequency / static_cast<float>(sampleRate));
+        const auto nSquared = n * n;
+        const auto invQ = 1.f / Q;
+        const auto c1 = 1.f / (1.f + invQ * n + nSquared);
+
+        return normalise(c1, c1 * 2.f, c1, 1.f, c1 * 2.f * (1.f - nSquared), c1 * (1.f - invQ * n + nSquared));
+    }
+
+    BiquadCoefficients makeHighPass(double sampleRate, float frequency, float Q)
+    {
+        const auto n = std::tan(float(pi) * frequency / static_cast<float>(sampleRate));
+        const auto nSquared = n * n;
+        const auto invQ = 1.f / Q;
+        const auto c1 = 1.f / (1.f + invQ * n + nSquared);
+
+        return normalise(c1, c1 * -2.f, c1, 1.f, c1 * 2.f * (nSquared - 1.f), c1 * (1.f - invQ * n + nSquared));
+    }
+
+    //the Butterworth Q of each biquad in an even order cascade
+    float butterworthQ(int section, int order)
+    {
+        return static_cast<float>(1.0 / (2.0 * std::cos((2.0 * section + 1.0) * pi / (order * 2.0))));
+    }
+
+    int getCutOrder(Slope slope) { return 2 * (slope + 1); }
+}
+
+BiquadCoefficients designPeakFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    const auto gainFactor = std::pow(10.f, chainSettings.peakGain * 0.05f);
+    const auto A = std::max(0.f, std::sqrt(gainFactor));
+    const auto omega = (2.f * float(pi) * std::max(chainSettings.peakFreq, 2.f)) / static_cast<float>(sampleRate);
+    const auto alpha = std::sin(omega) / (chainSettings.peakQuality * 2.f);
+    const auto c2 = -2.f * std::cos(omega);
+    const auto alphaTimesA = alpha * A;
+    const auto alphaOverA = alpha / A;
+
+    return normalise(1.f + alphaTimesA, c2, 1.f - alphaTimesA, 1.f + alphaOverA, c2, 1.f - alphaOverA);
+}
+
+int designLowCutFilter(const ChainSettings& chainSettings, double sampleRate, CutCoefficients& sections)
+{
+    const auto order = getCutOrder(chainSettings.lowCutSlope);
+    const auto numSections = order / 2;
+
+    for (int i = 0; i < numSections; ++i)
+        sections[i] = makeHighPass(sampleRate, chainSettings.lowCutFreq, butterworthQ(i, order));
+
+    return numSections;
+}
+
+int designHighCutFilter(const ChainSettings& chainSettings, double sampleRate, CutCoefficients& sections)
+{
+    const auto order = getCutOrder(chainSettings.highCutSlope);
+    const auto numSections = order / 2;
+
+    for (int i = 0; i < numSections; ++i)
+        sections[i] = makeLowPass(sampleRate, chainSettings.highCutFreq, butterworthQ(i, order));
+
+    return numSections;
+}
+
+void designKWeighting(double sampleRate, BiquadCoefficients& shelf, BiquadCoefficients& highPass)
+{
+    //designed in double, the shelf's poles sit close to the unit circle at high rates
+    {
+        const auto frequency = 1681.974450955533;
+        const auto gain = 3.999843853973347;
+        const auto Q = 0.7071752369554196;
+
+        const auto K = std::tan(pi * frequency / sampleRate);
+        const auto Vh = std::pow(10.0, gain / 20.0);
+        const auto Vb = std::pow(Vh, 0.4996667741545416);
+        const auto a0 = 1.0 + K / Q + K * K;
+
+        shelf = { float((Vh + Vb * K / Q + K * K) / a0),
+                  float(2.0 * (K * K - Vh) / a0),
+                  float((Vh - Vb * K / Q + K * K) / a0),
+                  float(2.0 * (K * K - 1.0) / a0),
+                  float((1.0 - K / Q + K * K) / a0) };
+    }
+
+    //the numerator is left unnormalised, as in the recommendation
+    {
+        const auto frequency = 38.13547087602444;
+        const auto Q = 0.5003270373238773;
+
+        const auto K = std::tan(pi * frequency / sampleRate);
+        const auto a0 = 1.0 + K / Q + K * K;
+
+        highPass = { 1.f,
+                     -2.f,
+                     1.f,
+                     float(2.0 * (K * K - 1.0) / a0),
+                     float((1.0 - K / Q + K * K) / a0) };
+    }
+}
+
+//==============================================================================
+void FilterChain::setSettings(const ChainSettings& chainSettings, double sampleRate)
+{
+    CutCoefficients sections;
+
+    auto numLowCut = designLowCutFilter(chainSettings, sampleRate, sections);
+    for (int i = 0; i < MaxCutSections; ++i)
+    {
+        if (i < numLowCut)
+            stages[LowCutStage + i].coefficients = sections[i];
+
+        active[LowCutStage + i] = !chainSettings.lowCutBypassed && i < numLowCut;
+    }
+
+    stages[PeakStage].coefficients = designPeakFilter(chainSettings, sampleRate);
+    active[PeakStage] = !chainSettings.peakBypassed;
+
+    auto numHighCut = designHighCutFilter(chainSettings, sampleRate, sections);
+    for (int i = 0; i < MaxCutSections; ++i)
+    {
+        if (i < numHighCut)
+            stages[HighCutStage + i].coefficients = sections[i];
+
+        active[HighCutStage + i] = !chainSettings.highCutBypassed && i < numHighCut;
+    }
+}
+
+void FilterChain::reset()
+{
+    for (auto& stage : stages)
+        stage.reset();
+}
+
+void FilterChain::process(float* samples, int numSamples, int stride)
+{
+    for (int i = 0; i < NumChainStages; ++i)
+    {
+        if (active[i])
+            stages[i].process(samples, numSamples, stride);
+    }
+}
+
+//==============================================================================
+void Processor::prepare(double newSampleRate, int maximumBlockSize, int numChannels)
+{
+    //nothing is buffered per block, so the block size only matters to callers that size their own buffers
+    (void)maximumBlockSize;
+
+    sampleRate = newSampleRate;
+    chains.assign((size_t)numChannels, FilterChain());
+
+    setSettings(settings);
+}
+
+void Processor::setSettings(const ChainSettings& chainSettings)
+{
+    settings = chainSettings;
+
+    if (sampleRate <= 0.0)
+        return;
+
+    //the plugin's parameter ranges keep it away from these, a caller of the library may not.
+    //a cutoff of 0 or at nyquist makes the tan() in the designs blow up into NaN coefficients
+    auto limited = settings;
+    const auto maxFrequency = static_cast<float>(0.49 * sampleRate);
+
+    limited.lowCutFreq = std::clamp(limited.lowCutFreq, 1.f, maxFrequency);
+    limited.highCutFreq = std::clamp(limited.highCutFreq, 1.f, maxFrequency);
+    limited.peakFreq = std::clamp(limited.peakFreq, 1.f, maxFrequency);
+    limited.peakQuality = std::max(limited.peakQuality, 0.01f);
+
+    for (auto& chain : chains)
+        chain.setSettings(limited, sampleRate);
+}
+
+void Processor::reset()
+{
+    for (auto& chain : chains)
+        chain.reset();
+}
+
+void Processor::processPlanar(float* const* channels, int numFrames)
+{
+    for (size_t ch = 0; ch < chains.size(); ++ch)
+        chains[ch].process(channels[ch], numFrames);
+}
+
+void Processor::processInterleaved(float* samples, int numFrames)
+{
+    const auto numChannels = getNumChannels();
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        chains[(size_t)ch].process(samples + ch, numFrames, numChannels);
+}
+
+//==============================================================================
+FFT::FFT(int order) : size(1 << order)
+{
+    twiddles.resize((size_t)size / 2);
+    for (int k = 0; k < size / 2; ++k)
+    {
+        auto angle = -2.0 * pi * k / size;
+        twiddles[(size_t)k] = { (float)std::cos(angle), (float)std::sin(angle) };
+    }
+
+    bitReversed.resize((size_t)size);
+    for (int i = 0; i < size; ++i)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < order; ++bit)
+            reversed |= ((i >> bit) & 1) << (order - 1 - bit);
+
+        bitReversed[(size_t)i] = reversed;
+    }
+}
+
+void FFT::perform(std::complex<float>* data) const
+{
+    for (int i = 0; i < size; ++i)
+    {
+        auto j = bitReversed[(size_t)i];
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+
+    for (int length = 2; length <= size; length <<= 1)
+    {
+        const auto half = length / 2;
+        const auto step = size / length;
+
+        for (int start = 0; start < size; start += length)
+        {
+            for (int k = 0; k < half; ++k)
+            {
+                auto u = data[start + k];
+                auto v = data[start + k + half] * twiddles[(size_t)(k * step)];
+                data[start + k] = u + v;
+                data[start + k + half] = u - v;
+            }
+        }
+    }
+}
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer(int order) : fft(order)
+{
+    const auto fftSize = (size_t)fft.getSize();
+
+    //normalised Blackman-Harris, as juce::dsp::WindowingFunction builds it
+    window.resize(fftSize);
+    double sum = 0.0;
+    for (size_t i = 0; i < fftSize; ++i)
+    {
+        auto x = (double)i / (double)(fftSize - 1);
+        auto w = 0.35875
+               - 0.48829 * std::cos(2.0 * pi * x)
+               + 0.14128 * std::cos(4.0 * pi * x)
+               - 0.01168 * std::cos(6.0 * pi * x);
+        window[i] = (float)w;
+        sum += window[i];
+    }
+
+    const auto factor = (float)((double)fftSize / sum);
+    for (auto& w : window)
+        w *= factor;
+
+    buffer.resize(fftSize);
+}
+
+void SpectrumAnalyzer::process(const float* samples, float* decibels, float negativeInfinity)
+{
+    const auto fftSize = fft.getSize();
+    const auto numBins = getNumBins();
+
+    for (int i = 0; i < fftSize; ++i)
+        buffer[(size_t)i] = { samples[i] * window[(size_t)i], 0.f };
+
+    fft.perform(buffer.data());
+
+    for (int i = 0; i < numBins; ++i)
+    {
+        auto v = std::abs(buffer[(size_t)i]);
+
+        if (!std::isinf(v) && !std::isnan(v))
+            v /= float(numBins);
+        else
+            v = 0.f;
+
+        decibels[i] = v > 0.f ? std::max(negativeInfinity, std::log10(v) * 20.f) : negativeInfinity;
+    }
+}
+
+} // namespace eqcore
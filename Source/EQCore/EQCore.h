@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+    EQCore.h
+
+    The EQ's DSP without any JUCE dependency: the settings, the filter design,
+    the filter cascades and a plain single channel spectrum analyzer.
+    The plugin builds its juce::dsp coefficients from the functions in here,
+    and the C API in eq_core.h wraps the same code for embedding elsewhere.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <complex>
+#include <vector>
+
+enum Slope {
+  Slope_12,
+  Slope_24,
+  Slope_36,
+  Slope_48
+};
+
+struct ChainSettings
+{
+    float peakFreq { 0 }, peakGain{ 0 }, peakQuality { 1.f };
+    float lowCutFreq { 0 }, highCutFreq { 0 };
+
+    Slope lowCutSlope{ Slope::Slope_12 };
+    Slope highCutSlope { Slope::Slope_12 };
+
+    bool lowCutBypassed{ false }, peakBypassed{ false }, highCutBypassed{ false };
+
+};
+
+namespace eqcore
+{
+
+/**
+ normalised biquad coefficients (a0 == 1), the same layout juce::dsp::IIR::Coefficients stores.
+ */
+struct BiquadCoefficients
+{
+    float b0 { 1.f }, b1 { 0.f }, b2 { 0.f }, a1 { 0.f }, a2 { 0.f };
+};
+
+//a cut filter is at most 4 biquads (48 dB/Oct)
+static constexpr int MaxCutSections = 4;
+using CutCoefficients = std::array<BiquadCoefficients, MaxCutSections>;
+
+/*
+ these reproduce juce::dsp::IIR::Coefficients::makePeakFilter and
+ FilterDesign::designIIR{High,Low}passHighOrderButterworthMethod step for step,
+ so the plugin and anything embedding the core get identical filters.
+ the cut designs return the number of sections used, which is slope + 1.
+ */
+BiquadCoefficients designPeakFilter(const ChainSettings& chainSettings, double sampleRate);
+int designLowCutFilter(const ChainSettings& chainSettings, double sampleRate, CutCoefficients& sections);
+int designHighCutFilter(const ChainSettings& chainSettings, double sampleRate, CutCoefficients& sections);
+
+/**
+ the two K-weighting stages of ITU-R BS.1770: a ~+4 dB high shelf for the head, then the ~38 Hz
+ RLB high-pass. at 48 kHz they match the recommendation's tabulated coefficients, at other
+ rates they're redesigned from the same prototypes.
+ */
+void designKWeighting(double sampleRate, BiquadCoefficients& shelf, BiquadCoefficients& highPass);
+
+/**
+ one transposed direct form II section. same arithmetic as juce::dsp::IIR::Filter.
+ */
+struct Biquad
+{
+    BiquadCoefficients coefficients;
+
+    void reset() { s1 = s2 = 0.f; }
+
+    void process(float* samples, int numSamples, int stride)
+    {
+        const auto c = coefficients;
+        auto lv1 = s1;
+        auto lv2 = s2;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto& sample = samples[i * stride];
+            auto input = sample;
+            auto output = (c.b0 * input) + lv1;
+            lv1 = (c.b1 * input) - (c.a1 * output) + lv2;
+            lv2 = (c.b2 * input) - (c.a2 * output);
+            sample = output;
+        }
+
+        s1 = snapToZero(lv1);
+        s2 = snapToZero(lv2);
+    }
+private:
+    float s1 = 0.f, s2 = 0.f;
+
+    static float snapToZero(float v) { return (v > -1.0e-8f && v < 1.0e-8f) ? 0.f : v; }
+};
+
+enum ChainStage
+{
+    LowCutStage = 0,                          //4 sections
+    PeakStage = MaxCutSections,               //1 section
+    HighCutStage = MaxCutSections + 1,        //4 sections
+    NumChainStages = 2 * MaxCutSections + 1
+};
+
+/**
+ the LowCut -> Peak -> HighCut cascade for one channel, like the plugin's MonoChain.
+ */
+struct FilterChain
+{
+    void setSettings(const ChainSettings& chainSettings, double sampleRate);
+    void reset();
+
+    void process(float* samples, int numSamples, int stride = 1);
+private:
+    std::array<Biquad, NumChainStages> stages;
+    std::array<bool, NumChainStages> active {};
+};
+
+/**
+ a multichannel EQ: one FilterChain per channel, all sharing the same settings.
+ setSettings() never allocates, so it is safe to call from the audio thread.
+ */
+struct Processor
+{
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels);
+
+    //frequencies are clamped to [1 Hz, 0.49 * sampleRate] and Q to at least 0.01 before designing
+    void setSettings(const ChainSettings& chainSettings);
+    void reset();
+
+    void processPlanar(float* const* channels, int numFrames);
+    void processInterleaved(float* samples, int numFrames);
+
+    bool isPrepared() const { return !chains.empty(); }
+    int getNumChannels() const { return (int)chains.size(); }
+    double getSampleRate() const { return sampleRate; }
+private:
+    double sampleRate = 0.0;
+    ChainSettings settings;
+    std::vector<FilterChain> chains;
+};
+
+/**
+ radix-2 complex FFT with precomputed twiddles and bit reversal.
+ */
+struct FFT
+{
+    explicit FFT(int order);
+
+    int getSize() const { return size; }
+
+    void perform(std::complex<float>* data) const;
+private:
+    int size;
+    std::vector<std::complex<float>> twiddles;
+    std::vector<int> bitReversed;
+};
+
+/**
+ a straightforward single channel analyzer: Blackman-Harris window, magnitude spectrum,
+ normalisation by the number of bins and 20 * log10, floored at 'negativeInfinity'.
+
+ this is not the plugin's analyzer and isn't kept in step with it. FFTDataGenerator transforms
+ both channels in one packed complex FFT, stays in the power domain and uses an approximate log,
+ so its levels agree with these only to within a small fraction of a dB, and only for the same
+ window length and window position. only the filter designs above are shared with the plugin.
+ */
+struct SpectrumAnalyzer
+{
+    explicit SpectrumAnalyzer(int order);
+
+    int getFFTSize() const { return fft.getSize(); }
+    int getNumBins() const { return fft.getSize() / 2; }
+
+    /**
+     reads getFFTSize() samples and writes getNumBins() decibel values.
+     */
+    void process(const float* samples, float* decibels, float negativeInfinity);
+private:
+    FFT fft;
+    std::vector<float> window;
+    std::vector<std::complex<float>> buffer;
+};
+
+} // namespace eqcore
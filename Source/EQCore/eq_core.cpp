@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    eq_core.cpp
+
+  ==============================================================================
+*/
+
+#include "eq_core.h"
+#include "EQCore.h"
+
+#include <cmath>
+#include <new>
+
+struct eqcore_instance
+{
+    eqcore::Processor processor;
+};
+
+struct eqcore_analyzer
+{
+    explicit eqcore_analyzer(int order) : analyzer(order) {}
+
+    eqcore::SpectrumAnalyzer analyzer;
+};
+
+namespace
+{
+    Slope toSlope(int slope)
+    {
+        return static_cast<Slope>(slope < Slope_12 ? Slope_12 : (slope > Slope_48 ? Slope_48 : slope));
+    }
+
+    ChainSettings toChainSettings(const eqcore_settings& s)
+    {
+        ChainSettings settings;
+
+        settings.lowCutFreq = s.low_cut_freq;
+        settings.lowCutSlope = toSlope(s.low_cut_slope);
+        settings.lowCutBypassed = s.low_cut_bypassed != 0;
+
+        settings.peakFreq = s.peak_freq;
+        settings.peakGain = s.peak_gain_db;
+        settings.peakQuality = s.peak_quality;
+        settings.peakBypassed = s.peak_bypassed != 0;
+
+        settings.highCutFreq = s.high_cut_freq;
+        settings.highCutSlope = toSlope(s.high_cut_slope);
+        settings.highCutBypassed = s.high_cut_bypassed != 0;
+
+        return settings;
+    }
+
+    bool isPositive(float value) { return std::isfinite(value) && value > 0.f; }
+
+    bool isValid(const eqcore_settings& s)
+    {
+        return isPositive(s.low_cut_freq) && isPositive(s.high_cut_freq) && isPositive(s.peak_freq)
+            && isPositive(s.peak_quality) && std::isfinite(s.peak_gain_db);
+    }
+
+    //the core allocates in prepare and in the analyzer's constructor, nothing may escape the C ABI
+    template<typename Function>
+    eqcore_result guarded(Function&& function)
+    {
+        try
+        {
+            return function();
+        }
+        catch (const std::bad_alloc&)
+        {
+            return EQCORE_ERROR_OUT_OF_MEMORY;
+        }
+        catch (...)
+        {
+            return EQCORE_ERROR_INTERNAL;
+        }
+    }
+}
+
+void eqcore_default_settings(eqcore_settings* settings)
+{
+    if (settings == nullptr)
+        return;
+
+    settings->low_cut_freq = 20.f;
+    settings->low_cut_slope = Slope_12;
+    settings->low_cut_bypassed = 0;
+
+    settings->peak_freq = 750.f;
+    settings->peak_gain_db = 0.f;
+    settings->peak_quality = 1.f;
+    settings->peak_bypassed = 0;
+
+    settings->high_cut_freq = 20000.f;
+    settings->high_cut_slope = Slope_12;
+    settings->high_cut_bypassed = 0;
+}
+
+eqcore_instance* eqcore_create(void)
+{
+    try
+    {
+        auto* instance = new eqcore_instance();
+
+        eqcore_settings defaults;
+        eqcore_default_settings(&defaults);
+        instance->processor.setSettings(toChainSettings(defaults));
+
+        return instance;
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void eqcore_destroy(eqcore_instance* instance)
+{
+    delete instance;
+}
+
+eqcore_result eqcore_prepare(eqcore_instance* instance, double sample_rate, int max_block_size, int num_channels)
+{
+    if (instance == nullptr || !std::isfinite(sample_rate) || sample_rate <= 0.0 || max_block_size <= 0 || num_channels <= 0)
+        return EQCORE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]
+    {
+        instance->processor.prepare(sample_rate, max_block_size, num_channels);
+        return EQCORE_OK;
+    });
+}
+
+eqcore_result eqcore_reset(eqcore_instance* instance)
+{
+    if (instance == nullptr)
+        return EQCORE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]
+    {
+        instance->processor.reset();
+        return EQCORE_OK;
+    });
+}
+
+eqcore_result eqcore_set_settings(eqcore_instance* instance, const eqcore_settings* settings)
+{
+    if (instance == nullptr || settings == nullptr || !isValid(*settings))
+        return EQCORE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]
+    {
+        instance->processor.setSettings(toChainSettings(*settings));
+        return EQCORE_OK;
+    });
+}
+
+eqcore_result eqcore_process_interleaved(eqcore_instance* instance, float* samples, int num_frames)
+{
+    if (instance == nullptr || samples == nullptr || num_frames < 0)
+        return EQCORE_ERROR_INVALID_ARGUMENT;
+
+    if (!instance->processor.isPrepared())
+        return EQCORE_ERROR_NOT_PREPARED;
+
+    return guarded([&]
+    {
+        instance->processor.processInterleaved(samples, num_frames);
+        return EQCORE_OK;
+    });
+}
+
+eqcore_result eqcore_process_planar(eqcore_instance* instance, float* const* channels, int num_frames)
+{
+    if (instance == nullptr || channels == nullptr || num_frames < 0)
+        return EQCORE_ERROR_INVALID_ARGUMENT;
+
+    if (!instance->processor.isPrepared())
+        return EQCORE_ERROR_NOT_PREPARED;
+
+    return guarded([&]
+    {
+        instance->processor.processPlanar(channels, num_frames);
+        return EQCORE_OK;
+    });
+}
+
+eqcore_analyzer* eqcore_analyzer_create(int order)
+{
+    if (order < 4 || order > 16)
+        return nullptr;
+
+    //nothrow only covers the object itself, not the vectors its constructor allocates
+    try
+    {
+        return new eqcore_analyzer(order);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void eqcore_analyzer_destroy(eqcore_analyzer* analyzer)
+{
+    delete analyzer;
+}
+
+int eqcore_analyzer_get_fft_size(const eqcore_analyzer* analyzer)
+{
+    return analyzer != nullptr ? analyzer->analyzer.getFFTSize() : 0;
+}
+
+eqcore_result eqcore_analyzer_process(eqcore_analyzer* analyzer, const float* samples, float* decibels, float negative_infinity)
+{
+    if (analyzer == nullptr || samples == nullptr || decibels == nullptr)
+        return EQCORE_ERROR_INVALID_ARGUMENT;
+
+    return guarded([&]
+    {
+        analyzer->analyzer.process(samples, decibels, negative_infinity);
+        return EQCORE_OK;
+    });
+}
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    eq_core.h
+
+    C interface to the EQ core. Everything in here is plain C so the library
+    can be loaded from any language or host without JUCE.
+
+  ==============================================================================
+*/
+
+#ifndef EQ_CORE_H
+#define EQ_CORE_H
+
+#if defined(EQCORE_SHARED)
+ #if defined(_WIN32)
+  #if defined(EQCORE_BUILDING_SHARED)
+   #define EQCORE_API __declspec(dllexport)
+  #else
+   #define EQCORE_API __declspec(dllimport)
+  #endif
+ #else
+  #define EQCORE_API __attribute__((visibility("default")))
+ #endif
+#else
+ #define EQCORE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum eqcore_result
+{
+    EQCORE_OK = 0,
+    EQCORE_ERROR_INVALID_ARGUMENT = -1,
+    EQCORE_ERROR_NOT_PREPARED = -2,
+    EQCORE_ERROR_OUT_OF_MEMORY = -3,
+    EQCORE_ERROR_INTERNAL = -4
+} eqcore_result;
+
+/* slopes are 0 = 12, 1 = 24, 2 = 36, 3 = 48 dB/Oct */
+typedef struct eqcore_settings
+{
+    float low_cut_freq;
+    int low_cut_slope;
+    int low_cut_bypassed;
+
+    float peak_freq;
+    float peak_gain_db;
+    float peak_quality;
+    int peak_bypassed;
+
+    float high_cut_freq;
+    int high_cut_slope;
+    int high_cut_bypassed;
+} eqcore_settings;
+
+typedef struct eqcore_instance eqcore_instance;
+typedef struct eqcore_analyzer eqcore_analyzer;
+
+/*
+ no C++ exception ever leaves these functions: the ones returning eqcore_result report
+ failures as error codes, the ones returning a pointer return NULL.
+ */
+
+/* fills 'settings' with the plugin's parameter defaults */
+EQCORE_API void eqcore_default_settings(eqcore_settings* settings);
+
+EQCORE_API eqcore_instance* eqcore_create(void);
+EQCORE_API void eqcore_destroy(eqcore_instance* instance);
+
+/* allocates everything; the calls below never allocate. sample_rate has to be finite and positive */
+EQCORE_API eqcore_result eqcore_prepare(eqcore_instance* instance, double sample_rate, int max_block_size, int num_channels);
+EQCORE_API eqcore_result eqcore_reset(eqcore_instance* instance);
+/*
+ frequencies and peak_quality have to be finite and positive, peak_gain_db finite.
+ frequencies at or above nyquist are clamped to just below it.
+ */
+EQCORE_API eqcore_result eqcore_set_settings(eqcore_instance* instance, const eqcore_settings* settings);
+
+/* filters in place. interleaved data is num_frames * num_channels floats */
+EQCORE_API eqcore_result eqcore_process_interleaved(eqcore_instance* instance, float* samples, int num_frames);
+EQCORE_API eqcore_result eqcore_process_planar(eqcore_instance* instance, float* const* channels, int num_frames);
+
+/* the analyzer pipeline: window, FFT, normalisation, decibels. order 11 is a 2048 point FFT */
+EQCORE_API eqcore_analyzer* eqcore_analyzer_create(int order);
+EQCORE_API void eqcore_analyzer_destroy(eqcore_analyzer* analyzer);
+EQCORE_API int eqcore_analyzer_get_fft_size(const eqcore_analyzer* analyzer);
+
+/* reads fft_size samples and writes fft_size / 2 decibel values */
+EQCORE_API eqcore_result eqcore_analyzer_process(eqcore_analyzer* analyzer, const float* samples, float* decibels, float negative_infinity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EQ_CORE_H */
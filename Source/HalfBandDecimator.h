@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    HalfBandDecimator.h
+
+    Halves a mono stream's sample rate with a linear phase half-band FIR.
+    Used by the analyzer to get octave bands and to drop content above
+    the display range at high sample rates.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ a 63 tap half-band lowpass followed by dropping every second sample.
+ every other tap of a half-band filter is zero, so each output sample costs
+ 16 multiplies. the passband is flat to about 0.2 * the input rate and
+ everything above 0.3 * the input rate is down by at least 80 dB.
+ */
+struct HalfBandDecimator
+{
+    static constexpr int numTaps = 63;
+    static constexpr int centre = numTaps / 2;
+
+    HalfBandDecimator() { reset(); }
+
+    void reset()
+    {
+        history.fill(0.f);
+        position = 0;
+        skipNext = false;
+    }
+
+    /**
+     decimates 'numSamples' from 'input' into 'output' and returns the number of samples written,
+     which is numSamples / 2, rounded up or down depending on where the previous call left off.
+     'output' may not alias 'input'.
+     */
+    int process(const float* input, float* output, int numSamples)
+    {
+        const auto& h = getCoefficients();
+        int numOutput = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            //the history is stored twice, so the newest numTaps samples are always contiguous from 'position'
+            position = (position + numTaps - 1) % numTaps;
+            history[position] = history[position + numTaps] = input[i];
+
+            skipNext = !skipNext;
+            if (!skipNext)
+                continue;
+
+            //x[k] is the input k samples ago. symmetric taps are folded, the zero ones skipped.
+            const auto* x = history.data() + position;
+            auto sum = h[centre] * x[centre];
+
+            for (int k = 0; k < centre; k += 2)
+                sum += h[k] * (x[k] + x[numTaps - 1 - k]);
+
+            output[numOutput++] = sum;
+        }
+
+        return numOutput;
+    }
+private:
+    std::array<float, numTaps * 2> history;
+    int position = 0;
+    bool skipNext = false;
+
+    //windowed sinc with its cutoff at a quarter of the input rate, Kaiser window for ~80 dB
+    static const std::array<float, numTaps>& getCoefficients()
+    {
+        static const auto coefficients = []
+        {
+            std::array<float, numTaps> h;
+            juce::dsp::WindowingFunction<float>::fillWindowingTables(h.data(), (size_t)numTaps,
+                juce::dsp::WindowingFunction<float>::kaiser, false, 7.86f);
+
+            float sum = 0.f;
+            for (int k = 0; k < numTaps; ++k)
+            {
+                const auto offset = k - centre;
+
+                //sin(pi * n / 2) / (pi * n) is exactly zero for even n != 0
+                if (offset == 0)
+                    h[k] *= 0.5f;
+                else if (offset % 2 == 0)
+                    h[k] = 0.f;
+                else
+                    h[k] *= std::sin(juce::MathConstants<float>::halfPi * offset) / (juce::MathConstants<float>::pi * offset);
+
+                sum += h[k];
+            }
+
+            //unity gain at DC
+            for (auto& tap : h)
+                tap /= sum;
+
+            return h;
+        }();
+
+        return coefficients;
+    }
+};
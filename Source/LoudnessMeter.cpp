@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.cpp
+
+  ==============================================================================
+*/
+
+#include "LoudnessMeter.h"
+#include "PluginProcessor.h"
+
+void LoudnessMeter::prepare(double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    ticksPerSecond = (double)juce::Time::getHighResolutionTicksPerSecond();
+
+    eqcore::BiquadCoefficients shelf, highPass;
+    eqcore::designKWeighting(sampleRate, shelf, highPass);
+
+    for (auto& channel : filters)
+    {
+        channel.shelf.coefficients = makeCoefficients(shelf);
+        channel.highPass.coefficients = makeCoefficients(highPass);
+    }
+
+    stepSize = juce::jmax(1, juce::roundToInt(sampleRate * stepSeconds));
+
+    //2 stages of half-band FIRs, i.e. 4x, as BS.1770 asks for
+    oversampler = std::make_unique<juce::dsp::Oversampling<float>>(2, 2, juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, true);
+    oversampler->initProcessing((size_t)maxBlockSize);
+
+    smoothedTruePeakLoad = 0.0;
+    truePeakLoad.store(0.f);
+    wasMeasuringTruePeak = false;
+
+    reset();
+}
+
+void LoudnessMeter::reset()
+{
+    for (auto& channel : filters)
+    {
+        channel.shelf.reset();
+        channel.highPass.reset();
+    }
+
+    samplesInStep = 0;
+    stepEnergy = 0.0;
+    numSteps = 0;
+
+    binCounts.fill(0);
+    binEnergies.fill(0.0);
+    totalCount = 0;
+    totalEnergy = 0.0;
+
+    truePeakHold = 0.f;
+
+    const auto none = -std::numeric_limits<float>::infinity();
+    momentary.store(none);
+    shortTerm.store(none);
+    integrated.store(none);
+    truePeak.store(none);
+}
+
+void LoudnessMeter::process(const juce::AudioBuffer<float>& buffer, bool shouldMeasureTruePeak)
+{
+    if (stepSize == 0)
+        return;
+
+    if (resetRequested.exchange(false))
+        reset();
+
+    //mono counts once, anything past stereo is ignored. L and R both have weight 1.
+    const auto numChannels = juce::jmin(2, buffer.getNumChannels());
+    const auto numSamples = buffer.getNumSamples();
+
+    int position = 0;
+    while (position < numSamples)
+    {
+        //up to the end of the current 100 ms step
+        const auto num = juce::jmin(numSamples - position, stepSize - samplesInStep);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto& shelf = filters[channel].shelf;
+            auto& highPass = filters[channel].highPass;
+            const auto* samples = buffer.getReadPointer(channel, position);
+
+            float sum = 0.f;
+            for (int i = 0; i < num; ++i)
+            {
+                const auto weighted = highPass.processSample(shelf.processSample(samples[i]));
+                sum += weighted * weighted;
+            }
+
+            stepEnergy += sum;
+        }
+
+        position += num;
+        samplesInStep += num;
+
+        if (samplesInStep == stepSize)
+            finishStep();
+    }
+
+    for (auto& channel : filters)
+    {
+        channel.shelf.snapToZero();
+        channel.highPass.snapToZero();
+    }
+
+    if (shouldMeasureTruePeak)
+    {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        measureTruePeak(buffer, numChannels);
+
+        //smoothed like the QualityGovernor's load, over ~1 s
+        const auto budget = numSamples / sampleRate;
+        const auto blockLoad = (juce::Time::getHighResolutionTicks() - startTicks) / ticksPerSecond / budget;
+        smoothedTruePeakLoad += (1.0 - std::exp(-budget / 1.0)) * (blockLoad - smoothedTruePeakLoad);
+        truePeakLoad.store((float)smoothedTruePeakLoad);
+    }
+    else if (wasMeasuringTruePeak)
+    {
+        truePeakLoad.store(0.f);
+        smoothedTruePeakLoad = 0.0;
+    }
+
+    wasMeasuringTruePeak = shouldMeasureTruePeak;
+}
+
+void LoudnessMeter::measureTruePeak(const juce::AudioBuffer<float>& buffer, int numChannels)
+{
+    //the filters still hold whatever they saw when it was last switched off
+    if (!wasMeasuringTruePeak)
+        oversampler->reset();
+
+    juce::dsp::AudioBlock<const float> block(buffer.getArrayOfReadPointers(), (size_t)numChannels, (size_t)buffer.getNumSamples());
+
+    //the oversampler was prepared for maxBlockSize, some hosts go over it now and then
+    for (size_t start = 0; start < block.getNumSamples(); start += (size_t)maxBlockSize)
+    {
+        const auto length = juce::jmin((size_t)maxBlockSize, block.getNumSamples() - start);
+        const auto upsampled = oversampler->processSamplesUp(block.getSubBlock(start, length));
+
+        const auto range = upsampled.findMinAndMax();
+        truePeakHold = juce::jmax(truePeakHold, -range.getStart(), range.getEnd());
+    }
+
+    truePeak.store(juce::Decibels::gainToDecibels(truePeakHold, -std::numeric_limits<float>::infinity()));
+}
+
+double LoudnessMeter::getMeanEnergy(int numStepsBack) const
+{
+    double sum = 0.0;
+
+    for (int i = 0; i < numStepsBack; ++i)
+        sum += stepEnergies[(newestStep - i + shortTermSteps) % shortTermSteps];
+
+    return sum / numStepsBack;
+}
+
+void LoudnessMeter::finishStep()
+{
+    newestStep = (newestStep + 1) % shortTermSteps;
+    stepEnergies[newestStep] = stepEnergy / stepSize;
+    numSteps = juce::jmin(numSteps + 1, shortTermSteps);
+
+    stepEnergy = 0.0;
+    samplesInStep = 0;
+
+    //no reading until the window is full
+    if (numSteps >= momentarySteps)
+    {
+        const auto blockEnergy = getMeanEnergy(momentarySteps);
+        const auto blockLoudness = toLoudness(blockEnergy);
+        momentary.store((float)blockLoudness);
+
+        //every momentary window is a gating block
+        if (blockLoudness > absoluteGate)
+        {
+            const auto bin = juce::jlimit(0, numBins - 1, (int)((blockLoudness - absoluteGate) / binWidth));
+            ++binCounts[bin];
+            binEnergies[bin] += blockEnergy;
+            ++totalCount;
+            totalEnergy += blockEnergy;
+
+            updateIntegrated();
+        }
+    }
+
+    if (numSteps >= shortTermSteps)
+        shortTerm.store((float)toLoudness(getMeanEnergy(shortTermSteps)));
+}
+
+void LoudnessMeter::updateIntegrated()
+{
+    //everything in the histogram already passed the absolute gate
+    const auto threshold = toLoudness(totalEnergy / totalCount) + relativeGate;
+    const auto firstBin = juce::jlimit(0, numBins - 1, (int)((threshold - absoluteGate) / binWidth));
+
+    juce::int64 count = 0;
+    double energy = 0.0;
+
+    for (int bin = firstBin; bin < numBins; ++bin)
+    {
+        count += binCounts[bin];
+        energy += binEnergies[bin];
+    }
+
+    if (count > 0)
+        integrated.store((float)toLoudness(energy / count));
+}
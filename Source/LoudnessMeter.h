@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.h
+
+    ITU-R BS.1770 / EBU R128 loudness of the EQ's output: momentary,
+    short-term and gated integrated loudness, plus optional true-peak.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ measures on the audio thread and publishes through atomics, like the OutputMeter.
+ the K-weighted energy is summed per 100 ms step; momentary and short-term loudness
+ are the last 4 and 30 steps, and every 400 ms window (75% overlap) is a gating block.
+ gating blocks go into a fixed histogram of 0.1 LU bins that also keeps their exact energies,
+ so integrated loudness needs constant memory however long the programme runs, and the
+ relative gate is only ever off by the blocks within 0.1 LU of it.
+ */
+struct LoudnessMeter
+{
+    static constexpr double stepSeconds = 0.1;
+    static constexpr int momentarySteps = 4;
+    static constexpr int shortTermSteps = 30;
+
+    static constexpr double absoluteGate = -70.0;
+    static constexpr double relativeGate = -10.0;
+
+    //gating blocks louder than the top bin are counted in it
+    static constexpr double histogramTop = 10.0;
+    static constexpr double binWidth = 0.1;
+    static constexpr int numBins = int((histogramTop - absoluteGate) / binWidth);
+
+    //allocates the true-peak oversampler. call from prepareToPlay.
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    /**
+     audio thread, once per block after the filters. true-peak is 4x oversampled,
+     which costs more than the rest of the meter together, so it only runs when asked for.
+     */
+    void process(const juce::AudioBuffer<float>& buffer, bool measureTruePeak);
+
+    //any thread: starts a new integration (and true-peak hold) at the next block
+    void requestReset() { resetRequested.store(true); }
+
+    /**
+     LUFS, or -infinity until there's enough signal for a reading.
+     true-peak is the highest since the last reset in dBTP.
+     */
+    float getMomentary() const { return momentary.load(); }
+    float getShortTerm() const { return shortTerm.load(); }
+    float getIntegrated() const { return integrated.load(); }
+    float getTruePeak() const { return truePeak.load(); }
+
+    //what the true-peak oversampling costs, as a fraction of the blocks' realtime duration
+    float getTruePeakLoad() const { return truePeakLoad.load(); }
+private:
+    double sampleRate = 0.0;
+
+    struct ChannelFilters
+    {
+        juce::dsp::IIR::Filter<float> shelf, highPass;
+    };
+    std::array<ChannelFilters, 2> filters;
+
+    int stepSize = 0;
+    int samplesInStep = 0;
+    double stepEnergy = 0.0;
+
+    std::array<double, shortTermSteps> stepEnergies {};
+    int newestStep = 0;
+    int numSteps = 0;
+
+    std::array<juce::int64, numBins> binCounts {};
+    std::array<double, numBins> binEnergies {};
+    juce::int64 totalCount = 0;
+    double totalEnergy = 0.0;
+
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+    int maxBlockSize = 0;
+    bool wasMeasuringTruePeak = false;
+    float truePeakHold = 0.f;
+    double smoothedTruePeakLoad = 0.0;
+    double ticksPerSecond = 1.0;
+
+    std::atomic<bool> resetRequested { false };
+
+    std::atomic<float> momentary { -std::numeric_limits<float>::infinity() };
+    std::atomic<float> shortTerm { -std::numeric_limits<float>::infinity() };
+    std::atomic<float> integrated { -std::numeric_limits<float>::infinity() };
+    std::atomic<float> truePeak { -std::numeric_limits<float>::infinity() };
+    std::atomic<float> truePeakLoad { 0.f };
+
+    void reset();
+    void finishStep();
+    void updateIntegrated();
+    void measureTruePeak(const juce::AudioBuffer<float>& buffer, int numChannels);
+
+    double getMeanEnergy(int numStepsBack) const;
+    static double toLoudness(double energy) { return -0.691 + 10.0 * std::log10(energy); }
+};
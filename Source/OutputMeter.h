@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    OutputMeter.h
+
+    Peak, RMS and L/R correlation of the EQ's output, measured in the same
+    processBlock and published through atomics, so any thread can read them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct OutputMeter
+{
+    //RMS and correlation are averaged over about this long, like a VU meter
+    static constexpr double integrationSeconds = 0.3;
+    //peaks jump up instantly and fall back at this rate
+    static constexpr double peakReleaseDecibelsPerSecond = 20.0;
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        reset();
+    }
+
+    void reset()
+    {
+        peaks = { 0.0, 0.0 };
+        meanSquares = { 0.0, 0.0 };
+        meanProduct = 0.0;
+
+        for (auto& level : publishedPeaks)
+            level.store(0.f);
+        for (auto& level : publishedRMS)
+            level.store(0.f);
+        correlation.store(0.f);
+    }
+
+    /**
+     audio thread, once per block after the filters. one pass over both channels.
+     */
+    void process(const float* left, const float* right, int numSamples)
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return;
+
+        //every lane keeps its own partial results, so the sums are reassociated explicitly and the
+        //compiler can turn the inner loop into SIMD without fast-math. 8 lanes fill an AVX register.
+        constexpr int numLanes = 8;
+        float peakL[numLanes] {}, peakR[numLanes] {}, sumLL[numLanes] {}, sumRR[numLanes] {}, sumLR[numLanes] {};
+
+        int i = 0;
+        for (; i + numLanes <= numSamples; i += numLanes)
+        {
+            for (int k = 0; k < numLanes; ++k)
+            {
+                const auto l = left[i + k];
+                const auto r = right[i + k];
+
+                peakL[k] = juce::jmax(peakL[k], std::abs(l));
+                peakR[k] = juce::jmax(peakR[k], std::abs(r));
+                sumLL[k] += l * l;
+                sumRR[k] += r * r;
+                sumLR[k] += l * r;
+            }
+        }
+
+        for (int k = 0; i < numSamples; ++i, ++k)
+        {
+            const auto l = left[i];
+            const auto r = right[i];
+
+            peakL[k] = juce::jmax(peakL[k], std::abs(l));
+            peakR[k] = juce::jmax(peakR[k], std::abs(r));
+            sumLL[k] += l * l;
+            sumRR[k] += r * r;
+            sumLR[k] += l * r;
+        }
+
+        float blockPeakL = 0.f, blockPeakR = 0.f;
+        double blockLL = 0.0, blockRR = 0.0, blockLR = 0.0;
+
+        for (int k = 0; k < numLanes; ++k)
+        {
+            blockPeakL = juce::jmax(blockPeakL, peakL[k]);
+            blockPeakR = juce::jmax(blockPeakR, peakR[k]);
+            blockLL += sumLL[k];
+            blockRR += sumRR[k];
+            blockLR += sumLR[k];
+        }
+
+        const auto blockSeconds = numSamples / sampleRate;
+
+        const auto release = juce::Decibels::decibelsToGain(-peakReleaseDecibelsPerSecond * blockSeconds);
+        peaks[0] = juce::jmax((double)blockPeakL, peaks[0] * release);
+        peaks[1] = juce::jmax((double)blockPeakR, peaks[1] * release);
+
+        //one exponential step per block, weighted by the block's length
+        const auto alpha = 1.0 - std::exp(-blockSeconds / integrationSeconds);
+        meanSquares[0] += alpha * (blockLL / numSamples - meanSquares[0]);
+        meanSquares[1] += alpha * (blockRR / numSamples - meanSquares[1]);
+        meanProduct += alpha * (blockLR / numSamples - meanProduct);
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            publishedPeaks[channel].store((float)peaks[channel]);
+            publishedRMS[channel].store((float)std::sqrt(meanSquares[channel]));
+        }
+
+        //+1 in phase, 0 unrelated, -1 out of phase. silence counts as unrelated.
+        const auto energy = std::sqrt(meanSquares[0] * meanSquares[1]);
+        correlation.store(energy > 1e-10 ? (float)juce::jlimit(-1.0, 1.0, meanProduct / energy) : 0.f);
+    }
+
+    //linear gains, channel 0 is left. each value is consistent on its own, not necessarily with the others.
+    float getPeak(int channel) const { return publishedPeaks[channel].load(); }
+    float getRMS(int channel) const { return publishedRMS[channel].load(); }
+    float getCorrelation() const { return correlation.load(); }
+private:
+    double sampleRate = 0.0;
+
+    std::array<double, 2> peaks { 0.0, 0.0 };
+    std::array<double, 2> meanSquares { 0.0, 0.0 };
+    double meanProduct = 0.0;
+
+    std::array<std::atomic<float>, 2> publishedPeaks { { 0.f, 0.f } };
+    std::array<std::atomic<float>, 2> publishedRMS { { 0.f, 0.f } };
+    std::atomic<float> correlation { 0.f };
+};
@@ -241,24 +241,43 @@ juce::Rectangle<int> RotarySliderWithLabels::getSliderBounds() const
 }
 
 ResponseCurveComponent::ResponseCurveComponent(ParametricEQAudioProcessor& p) : audioProcessor(p), 
-leftPathProducer(audioProcessor.leftChannelFifo),
-rightPathProducer(audioProcessor.rightChannelFifo)
+meter(audioProcessor),
+pathProducer(audioProcessor.leftChannelFifo,
+    audioProcessor.rightChannelFifo,
+    audioProcessor.leftPreEQFifo,
+    audioProcessor.rightPreEQFifo,
+    audioProcessor.getPreEQTapPosition(),
+    audioProcessor.qualityGovernor,
+    audioProcessor.spectralHistory),
+analyzerTask(audioProcessor, pathProducer)
 {
+    //right clicks on the numbers still open the analyzer menu
+    meter.setInterceptsMouseClicks(false, false);
+    addAndMakeVisible(meter);
+
     const auto& params = audioProcessor.getParameters();
     for (auto param : params)
     {
         param->addListener(this);
     } 
     updateChain();
+
+
+    //anything the fifos collected before this editor opened is stale
+    analyzerTask.resetProducer();
+    audioProcessor.addAnalyzerConsumer();
+
     startTimerHz(60);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
+    audioProcessor.removeAnalyzerConsumer();
+
     const auto& params = audioProcessor.getParameters();
     for (auto param : params)
     {
-        param->addListener(this);
+        param->removeListener(this);
     }
 
 }
@@ -292,55 +311,1159 @@ void ResponseCurveComponent::updateChain() {
 
 }
 
+PathProducer::Band::Band()
+{
+    //the rings are allocated for the largest order up front
+    for (auto& buffer : windowBuffers)
+        buffer.resize(FFTDataGenerator<std::vector<float>>::maxFFTSize);
+
+    for (auto& buffer : decimated)
+        buffer.resize(maxChunkSize / 2 + 1);
+}
+
+void PathProducer::updateBands()
+{
+    const auto wanted = numBands.load();
+
+    if (wanted == activeBands)
+        return;
+
+    //new bands start at the same order as the first one
+    const auto order = activeBands > 0 ? bands[0]->fftDataGenerator.getOrder() : fftOrder.load();
+
+    for (int b = activeBands; b < wanted; ++b)
+    {
+        if (bands[b] == nullptr)
+            bands[b] = std::make_unique<Band>();
+
+        bands[b]->fftDataGenerator.changeOrder(order);
+        bands[b]->fftDataGenerator.resetOutputStage();
+        bands[b]->hasFrame = false;
+        prepareWindow(*bands[b]);
+    }
+
+    activeBands = wanted;
+}
+
+int PathProducer::getNumInputStages(double sampleRate)
+{
+    int stages = 0;
+
+    while (stages < maxInputStages && sampleRate / 2 >= 44100.0)
+    {
+        sampleRate /= 2;
+        ++stages;
+    }
+
+    return stages;
+}
+
+void PathProducer::updateInputStages(double sampleRate)
+{
+    const auto stages = getNumInputStages(sampleRate);
+
+    if (stages == numInputStages)
+        return;
+
+    numInputStages = stages;
+
+    //the bands' windows hold audio at the old rate, start them over
+    restartBands();
+}
+
+void PathProducer::updatePreEQTap()
+{
+    const auto wanted = preEQTap.load() && preEQTapPosition->offset.load() >= 0 ? maxSignals : preEQOffset;
+
+    if (wanted == numSignals)
+        return;
+
+    numSignals = wanted;
+
+    //the pre-EQ windows sat idle while the tap was off, and their decimators are out of phase
+    restartBands();
+}
+
+void PathProducer::restartBands()
+{
+    for (auto& stage : inputDecimators)
+        for (auto& decimator : stage)
+            decimator.reset();
+
+    for (int b = 0; b < activeBands; ++b)
+    {
+        prepareWindow(*bands[b]);
+        bands[b]->fftDataGenerator.resetOutputStage();
+        bands[b]->hasFrame = false;
+    }
+}
+
+void PathProducer::pushInput(Signals signals, int numSamples)
+{
+    for (int stage = 0; stage < numInputStages; ++stage)
+    {
+        auto& scratch = inputScratch[stage];
+
+        //all decimators are always in the same phase, so they return the same count
+        int numDecimated = 0;
+        for (int s = 0; s < numSignals; ++s)
+        {
+            numDecimated = inputDecimators[stage][s].process(signals[s], scratch[s].data(), numSamples);
+            signals[s] = scratch[s].data();
+        }
+
+        numSamples = numDecimated;
+    }
+
+    if (numSamples > 0)
+        pushSamples(0, signals, numSamples);
+}
+
+void PathProducer::updateOrderForQuality()
+{
+    auto order = static_cast<FFTOrder>(juce::jmax((int)FFTOrder::order512,
+        fftOrder.load() - qualityGovernor->getFFTOrderReduction()));
+
+    const auto oldSize = getFFTSize();
+
+    for (int b = 0; b < activeBands; ++b)
+    {
+        auto& band = *bands[b];
+
+        if (order == band.fftDataGenerator.getOrder())
+        {
+            band.fftDataGenerator.releaseUnusedPlans();
+            continue;
+        }
+
+        band.fftDataGenerator.changeOrder(order);
+        band.hasFrame = false;
+        resizeWindow(band, oldSize, band.fftDataGenerator.getFFTSize());
+    }
+}
+
+void PathProducer::prepareWindow(Band& band)
+{
+    for (auto& buffer : band.windowBuffers)
+        std::fill(buffer.begin(), buffer.end(), 0.f);
+
+    for (auto& decimator : band.decimators)
+        decimator.reset();
+
+    band.writeIndex = 0;
+    band.samplesUntilNextHop = getHopSize();
+}
+
+void PathProducer::resizeWindow(Band& band, int oldSize, int newSize)
+{
+    //keep the newest samples, so the first frame at the new size still shows the same audio
+    auto numToKeep = juce::jmin(oldSize, newSize);
+
+    for (auto& buffer : band.windowBuffers)
+    {
+        //unwrap oldest-first, then put the newest 'numToKeep' at the end of a fresh ring starting at 0
+        std::copy(buffer.begin() + band.writeIndex, buffer.begin() + oldSize, unwrapped.begin());
+        std::copy(buffer.begin(), buffer.begin() + band.writeIndex, unwrapped.begin() + (oldSize - band.writeIndex));
+
+        std::fill(buffer.begin(), buffer.begin() + (newSize - numToKeep), 0.f);
+        std::copy(unwrapped.begin() + (oldSize - numToKeep), unwrapped.begin() + oldSize,
+            buffer.begin() + (newSize - numToKeep));
+    }
+
+    band.writeIndex = 0;
+    band.samplesUntilNextHop = juce::jmin(band.samplesUntilNextHop, getHopSize());
+}
+
+void PathProducer::pushSamples(int bandIndex, const Signals& signals, int numSamples)
+{
+    jassert(numSamples <= maxChunkSize);
+
+    auto& band = *bands[bandIndex];
+
+    //the next band gets the same audio at half the rate
+    if (bandIndex + 1 < activeBands)
+    {
+        Signals decimated {};
+        int numDecimated = 0;
+
+        for (int s = 0; s < numSignals; ++s)
+        {
+            numDecimated = band.decimators[s].process(signals[s], band.decimated[s].data(), numSamples);
+            decimated[s] = band.decimated[s].data();
+        }
+
+        pushSamples(bandIndex + 1, decimated, numDecimated);
+    }
+
+    const auto fftSize = band.fftDataGenerator.getFFTSize();
+    const auto hasPreEQ = numSignals > preEQOffset;
+
+    int offset = 0;
+    while (offset < numSamples)
+    {
+        //stop at the ring's end and at the next hop, whichever comes first
+        auto num = juce::jmin(numSamples - offset, band.samplesUntilNextHop, fftSize - band.writeIndex);
+
+        for (int s = 0; s < numSignals; ++s)
+            juce::FloatVectorOperations::copy(band.windowBuffers[s].data() + band.writeIndex, signals[s] + offset, num);
+
+        band.writeIndex = (band.writeIndex + num) % fftSize;
+        band.samplesUntilNextHop -= num;
+        offset += num;
+
+        if (band.samplesUntilNextHop == 0)
+        {
+            band.fftDataGenerator.produceFFTDataForRendering(band.windowBuffers[Channel::Left].data(),
+                band.windowBuffers[Channel::Right].data(),
+                hasPreEQ ? band.windowBuffers[Channel::Left + preEQOffset].data() : nullptr,
+                hasPreEQ ? band.windowBuffers[Channel::Right + preEQOffset].data() : nullptr,
+                band.writeIndex,
+                -48.f,
+                [this, bandIndex](const float* left, const float* right, int numBins)
+                {
+                    if (recorder.isRecording())
+                        recorder.pushFrame(left, right, numBins, bandIndex, analysisSampleRate / (1 << bandIndex));
+                });
+            band.samplesUntilNextHop = getHopSize();
+        }
+    }
+}
+
+int PathProducer::getNumSamplesInAllFifos() const
+{
+    auto numSamples = channelFifos[0]->getNumSamplesAvailable();
+
+    for (int s = 1; s < numSignals; ++s)
+        numSamples = juce::jmin(numSamples, channelFifos[s]->getNumSamplesAvailable());
+
+    return numSamples;
+}
+
+bool PathProducer::alignPreEQFifos()
+{
+    const auto offset = preEQTapPosition->offset.load();
+    const auto firstSample = preEQTapPosition->firstSample.load();
+
+    //switched off since updatePreEQTap(), or switched again while reading
+    if (offset < 0 || offset != preEQTapPosition->offset.load())
+        return false;
+
+    //left and right are always read in step, so the left fifos' positions stand for both
+    auto& preEQFifo = *channelFifos[Channel::Left + preEQOffset];
+    auto& postEQFifo = *channelFifos[Channel::Left];
+    const auto samplesIn = juce::jmax((juce::int64)0,
+        preEQFifo.getNumSamplesRead() - firstSample,
+        postEQFifo.getNumSamplesRead() - (firstSample + offset));
+
+    bool skipped = false;
+
+    //moves a left/right pair of fifos up to 'target', as far as they have audio for it
+    auto skipTo = [this, &skipped](int first, juce::int64 target)
+    {
+        auto& left = *channelFifos[first + Channel::Left];
+        auto& right = *channelFifos[first + Channel::Right];
+
+        const auto numToSkip = (int)juce::jmin(target - left.getNumSamplesRead(),
+            (juce::int64)juce::jmin(left.getNumSamplesAvailable(), right.getNumSamplesAvailable()));
+
+        if (numToSkip > 0)
+        {
+            left.finishedReading(numToSkip);
+            right.finishedReading(numToSkip);
+            skipped = true;
+        }
+
+        return left.getNumSamplesRead() == target;
+    };
+
+    const auto preEQAligned = skipTo(preEQOffset, firstSample + samplesIn);
+    const auto postEQAligned = skipTo(0, firstSample + offset + samplesIn);
+
+    //the windows hold audio that was paired up wrongly
+    if (skipped)
+        restartBands();
+
+    return preEQAligned && postEQAligned;
+}
+
+void PathProducer::reset()
+{
+    {
+        const ScopedFifoLock fifoLock(channelFifos);
+        const auto numQueued = getNumSamplesInAllFifos();
+
+        for (int s = 0; s < numSignals; ++s)
+            channelFifos[s]->finishedReading(numQueued);
+    }
+
+    for (int b = 0; b < activeBands; ++b)
+    {
+        auto& band = *bands[b];
+        prepareWindow(band);
+
+        //drop whatever is still waiting in the mailboxes
+        band.fftDataGenerator.pullFFTData();
+        band.fftDataGenerator.resetOutputStage();
+        band.hasFrame = false;
+    }
+
+    spectrumRenderer.pullImage();
+    spectrogramRenderer.reset();
+    historyRenderer.reset();
+
+    //the history itself is the processor's, it's meant to outlive pauses and editors
+    hasImage = false;
+    hasHistoryImage = false;
+}
+
+bool PathProducer::pullImage()
+{
+    //only one of them is fed at a time, but any may still hold something from before a switch
+    auto anyNew = spectrogramRenderer.pullRows();
+
+    if (spectrumRenderer.pullImage())
+        hasImage = anyNew = true;
+
+    if (historyRenderer.pullImage())
+        hasHistoryImage = anyNew = true;
+
+    return anyNew;
+}
+
+const juce::Image& PathProducer::getImage() const
+{
+    if (view.load() == historyView)
+        return hasHistoryImage ? historyRenderer.getImage() : emptyImage;
+
+    return hasImage ? spectrumRenderer.getImage() : emptyImage;
+}
+
+//pointer to the sample 'offset' samples into 'spans', and how many samples follow it contiguously
+static const float* getSpanData(const SampleRing::Spans& spans, int offset, int& numContiguous)
+{
+    if (offset < spans.size1)
+    {
+        numContiguous = spans.size1 - offset;
+        return spans.data1 + offset;
+    }
+
+    numContiguous = spans.size2 - (offset - spans.size1);
+    return spans.data2 + (offset - spans.size1);
+}
+
+void PathProducer::updateOutputStage(double sampleRate)
+{
+    if (sampleRate <= 0.0)
+        return;
+
+    for (int b = 0; b < activeBands; ++b)
+    {
+        //the generator applies these once per frame, i.e. once per hop at the band's own rate
+        const auto hopSeconds = getHopSize() * (1 << b) / sampleRate;
+
+        bands[b]->fftDataGenerator.setOutputStage(analyzerMode.load(),
+            (float)(1.0 - std::exp(-hopSeconds / averagingTime.load())),
+            (float)(peakDecay.load() * hopSeconds));
+    }
+}
+
+void PathProducer::drainFifos()
+{
+    //the processor can't reallocate a ring while spans into it are out
+    const ScopedFifoLock fifoLock(channelFifos);
+
+    //the pre-EQ fifos are only fed while the tap is on, so they need lining up whenever it came on.
+    //until this side has switched over, whatever the processor already put in is dropped, so it can't
+    //pile up and overflow. the read counts keep track of it, so the alignment still comes out right.
+    if (numSignals > preEQOffset)
+    {
+        if (!alignPreEQFifos())
+            return;
+    }
+    else
+    {
+        const auto numStale = juce::jmin(channelFifos[Channel::Left + preEQOffset]->getNumSamplesAvailable(),
+            channelFifos[Channel::Right + preEQOffset]->getNumSamplesAvailable());
+
+        for (int s = preEQOffset; s < maxSignals; ++s)
+            channelFifos[s]->finishedReading(numStale);
+    }
+
+    //the audio thread fills the fifos one after the other, only take what all of them have
+    auto numAvailable = getNumSamplesInAllFifos();
+
+    if (numAvailable > 0)
+    {
+        //anything older than the slowest band's window would be overwritten before it's ever transformed
+        const auto maxBacklog = getFFTSize() << (activeBands - 1 + numInputStages);
+        if (numAvailable > maxBacklog)
+        {
+            for (int s = 0; s < numSignals; ++s)
+                channelFifos[s]->finishedReading(numAvailable - maxBacklog);
+
+            numAvailable = maxBacklog;
+        }
+
+        std::array<SampleRing::Spans, maxSignals> spans;
+        for (int s = 0; s < numSignals; ++s)
+            spans[s] = channelFifos[s]->readSamples(numAvailable);
+
+        //the rings wrap at different points, so walk them in pieces that are contiguous in each
+        int offset = 0;
+        while (offset < numAvailable)
+        {
+            Signals signals {};
+            auto num = juce::jmin(numAvailable - offset, (int)maxChunkSize);
+
+            for (int s = 0; s < numSignals; ++s)
+            {
+                int numContiguous;
+                signals[s] = getSpanData(spans[s], offset, numContiguous);
+                num = juce::jmin(num, numContiguous);
+            }
+
+            pushInput(signals, num);
+            offset += num;
+        }
+
+        for (int s = 0; s < numSignals; ++s)
+            channelFifos[s]->finishedReading(numAvailable);
+    }
+}
+
 void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
 {
-    juce::AudioBuffer<float> tempIncomingBuffer;
-    while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
+    updateBands();
+    updateOrderForQuality();
+    updateInputStages(sampleRate);
+    updatePreEQTap();
+
+    //from here on everything runs at the decimated rate
+    sampleRate /= (1 << numInputStages);
+
+    updateOutputStage(sampleRate);
+
+    analysisSampleRate = sampleRate;
+    drainFifos();
+
+    //only the newest frame of each band matters for drawing, older ones were already overwritten in the mailboxes
+    bool anyNewFrame = false;
+    for (int b = 0; b < activeBands; ++b)
+    {
+        if (bands[b]->fftDataGenerator.pullFFTData())
+        {
+            bands[b]->hasFrame = true;
+            anyNewFrame = true;
+        }
+    }
+
+    //the history comes from the processor and scrolls with the clock, so it doesn't wait for frames here
+    if (view.load() == historyView)
+    {
+        renderHistory(fftBounds);
+        return;
+    }
+
+    if (!anyNewFrame)
+        return;
+
+    const auto width = juce::roundToInt(fftBounds.getWidth());
+    const auto pixelsPerColumn = qualityGovernor->getPathResolution();
+
+    const auto octaveFraction = smoothing.load();
+
+    if (!columnMap.matches(getFFTSize(), sampleRate, activeBands, width, pixelsPerColumn, octaveFraction))
+    {
+        columnMap.prepare(getFFTSize(), sampleRate, activeBands, width, pixelsPerColumn, octaveFraction);
+
+        for (auto& levels : columnLevels)
+            levels.resize(columnMap.getColumns().size());
+
+        differenceLevels.resize(columnMap.getColumns().size());
+    }
+
+    //stitch the bands into one level per pixel column
+    for (auto channel : { Channel::Left, Channel::Right })
     {
-        if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer))
+        std::array<const float*, maxBands> bandFrames {};
+
+        for (int b = 0; b < activeBands; ++b)
         {
-            auto size = tempIncomingBuffer.getNumSamples();
+            if (bands[b]->hasFrame)
+                bandFrames[b] = bands[b]->fftDataGenerator.getFFTData(channel).data();
+        }
+
+        columnMap.reduce(bandFrames, -48.f, columnLevels[channel].data());
+    }
 
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
-                monoBuffer.getReadPointer(0, size),
-                monoBuffer.getNumSamples() - size);
+    const auto hasDifference = numSignals > preEQOffset;
 
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                tempIncomingBuffer.getReadPointer(0, 0),
-                size);
+    if (hasDifference)
+    {
+        std::array<const float*, maxBands> bandFrames {};
 
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
+        for (int b = 0; b < activeBands; ++b)
+        {
+            if (bands[b]->hasFrame)
+                bandFrames[b] = bands[b]->fftDataGenerator.getDifferenceData().data();
         }
+
+        columnMap.reduce(bandFrames, 0.f, differenceLevels.data(), SpectrumColumnMap::Reduction::mean);
+    }
+
+    const std::array<const float*, 2> levels { columnLevels[Channel::Left].data(), columnLevels[Channel::Right].data() };
+    const auto height = juce::roundToInt(fftBounds.getHeight());
+
+    switch (view.load())
+    {
+        case spectrumView:
+            spectrumRenderer.render(levels, hasDifference ? differenceLevels.data() : nullptr, columnMap, width, height, -48.f);
+            break;
+        case spectrogramView:
+            spectrogramRenderer.pushRow(levels, columnMap, width, height, -48.f);
+            break;
+        case historyView:
+            break;
     }
+}
 
-    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
-    const auto binWidth = sampleRate / double(fftSize);
+void PathProducer::renderHistory(juce::Rectangle<float> fftBounds)
+{
+    const auto width = juce::roundToInt(fftBounds.getWidth());
+    const auto height = juce::roundToInt(fftBounds.getHeight());
+    const auto span = historySpan.load();
+    const auto now = SpectralHistory::getCurrentTime();
+
+    //the history only changes every 100 ms, no need to redraw it on every call
+    if (historyRenderer.needsRender(spectralHistory, span, now, width, height))
+        historyRenderer.render(spectralHistory, span, now, width, height, -48.f);
+}
+
+void SpectrumImageRenderer::render(const std::array<const float*, 2>& columnLevels,
+    const float* differenceLevels,
+    const SpectrumColumnMap& columnMap,
+    int width,
+    int height,
+    float negativeInfinity)
+{
+    auto& image = imageBuffer.getWriteBuffer();
 
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+    //only the write slot is ever resized, the reader may still be drawing the others
+    if (image.getWidth() != width || image.getHeight() != height)
     {
-        std::vector<float> fftData;
-        if (leftChannelFFTDataGenerator.getFFTData(fftData))
+        if (width <= 0 || height <= 0)
+            return;
+
+        image = juce::Image(juce::Image::ARGB, width, height, true, juce::SoftwareImageType());
+    }
+
+    juce::Image::BitmapData bitmap(image, juce::Image::BitmapData::readWrite);
+
+    for (int y = 0; y < bitmap.height; ++y)
+        std::fill_n(bitmap.getLinePointer(y), (size_t)(bitmap.width * bitmap.pixelStride), (juce::uint8)0);
+
+    const auto& columns = columnMap.getColumns();
+    columnYs.resize(columns.size());
+
+    //same colours the analyzer paths used to be stroked with
+    const std::array<juce::Colour, 2> colours { juce::Colour(215u, 201u, 134u), juce::Colour(97u, 18u, 167u) };
+
+    //right first, so left ends up on top like before
+    for (auto channel : { Channel::Right, Channel::Left })
+    {
+        const auto* levels = columnLevels[channel];
+
+        for (size_t i = 0; i < columns.size(); ++i)
+            columnYs[i] = juce::jmap(levels[i], negativeInfinity, 0.f, float(height), 0.f);
+
+        drawLevels(bitmap, columns, colours[channel].getPixelARGB());
+    }
+
+    if (differenceLevels != nullptr)
+    {
+        //on the response curve's +-24 dB scale. the curve spans the render area, 4px more than ours at the top and bottom.
+        for (size_t i = 0; i < columns.size(); ++i)
+            columnYs[i] = juce::jmap(differenceLevels[i], -24.f, 24.f, height + 4.f, -4.f);
+
+        drawLevels(bitmap, columns, juce::Colour(0u, 180u, 216u).getPixelARGB());
+    }
+
+    imageBuffer.publish();
+}
+
+void SpectrumImageRenderer::drawLevels(const juce::Image::BitmapData& bitmap,
+    const std::vector<SpectrumColumnMap::Column>& columns,
+    juce::PixelARGB colour)
+{
+    //connect neighbouring column centres, one vertical span per pixel column in between
+    for (size_t i = 1; i < columns.size(); ++i)
+    {
+        const auto x1 = columns[i - 1].x, x2 = columns[i].x;
+        const auto y1 = columnYs[i - 1], y2 = columnYs[i];
+        const auto slope = (y2 - y1) / (x2 - x1);
+
+        for (auto x = (int)x1; x < (int)x2 && x < bitmap.width; ++x)
         {
-            pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
+            const auto start = y1 + slope * (x - x1);
+            drawSpan(bitmap, x, start, start + slope, colour);
         }
     }
+}
 
-    while (pathProducer.getNumPathsAvailable() > 0)
+void SpectrumImageRenderer::drawSpan(const juce::Image::BitmapData& bitmap, int x, float y1, float y2, juce::PixelARGB colour)
+{
+    //a 1px line: the span between the two ends, plus half a pixel each side. partly covered pixels get partial alpha.
+    const auto top = juce::jmin(y1, y2) - 0.5f;
+    const auto bottom = juce::jmax(y1, y2) + 0.5f;
+
+    const auto firstRow = juce::jmax(0, (int)std::floor(top));
+    const auto lastRow = juce::jmin(bitmap.height - 1, (int)std::ceil(bottom) - 1);
+
+    for (int row = firstRow; row <= lastRow; ++row)
     {
-        pathProducer.getPath(leftChannelFFTPath);
+        const auto coverage = juce::jmin(bottom, row + 1.f) - juce::jmax(top, (float)row);
+
+        auto pixel = colour;
+        pixel.multiplyAlpha(coverage);
+        reinterpret_cast<juce::PixelARGB*>(bitmap.getPixelPointer(x, row))->blend(pixel);
     }
 }
 
-void ResponseCurveComponent::timerCallback() {
+const std::array<juce::PixelARGB, SpectrogramRenderer::tableSize>& SpectrogramRenderer::getColourTable()
+{
+    static const auto colourTable = []
+    {
+        //quiet is transparent so the grid shows through, then the analyzer's purple and gold, white at 0 dB
+        const std::array<juce::Colour, 4> stops { juce::Colour(97u, 18u, 167u).withAlpha(0.f),
+                                                  juce::Colour(97u, 18u, 167u),
+                                                  juce::Colour(215u, 201u, 134u),
+                                                  juce::Colours::white };
+
+        std::array<juce::PixelARGB, tableSize> table;
+        for (int i = 0; i < tableSize; ++i)
+        {
+            const auto position = float(i) / (tableSize - 1) * (stops.size() - 1);
+            const auto stop = juce::jmin((int)position, (int)stops.size() - 2);
+            table[i] = stops[stop].interpolatedWith(stops[stop + 1], position - stop).getPixelARGB();
+        }
+
+        return table;
+    }();
+
+    return colourTable;
+}
+
+void SpectrogramRenderer::pushRow(const std::array<const float*, 2>& columnLevels,
+    const SpectrumColumnMap& columnMap,
+    int width,
+    int height,
+    float negativeInfinity)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    int start1, size1, start2, size2;
+    queue.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 == 0)
+        return;
+
+    //the slot is ours until finishedWrite(), so it may be resized here
+    auto& row = rows[start1];
+    row.pixels.resize((size_t)width);
+    row.historyLength = height;
+
+    const auto& columns = columnMap.getColumns();
+    const auto numColumns = (int)columns.size();
+
+    loudest.resize(columns.size());
+    juce::FloatVectorOperations::max(loudest.data(), columnLevels[Channel::Left], columnLevels[Channel::Right], numColumns);
+
+    const auto& colourTable = getColourTable();
+    const auto scale = (tableSize - 1) / -negativeInfinity;
+    const auto pixelsPerColumn = columnMap.getPixelsPerColumn();
+    auto* pixels = row.pixels.data();
+
+    //column i covers pixels [i * pixelsPerColumn, (i + 1) * pixelsPerColumn)
+    int x = 0;
+    for (int i = 0; i < numColumns; ++i)
+    {
+        const auto index = juce::jlimit(0, tableSize - 1, (int)((loudest[i] - negativeInfinity) * scale));
+        const auto end = juce::jmin(width, x + pixelsPerColumn);
+
+        std::fill(pixels + x, pixels + end, colourTable[index]);
+        x = end;
+    }
+
+    //above nyquist
+    std::fill(pixels + x, pixels + width, colourTable[0]);
+
+    queue.finishedWrite(1);
+}
+
+bool SpectrogramRenderer::pullRows()
+{
+    const auto numReady = queue.getNumReady();
+
+    if (numReady == 0)
+        return false;
+
+    int start1, size1, start2, size2;
+    queue.prepareToRead(numReady, start1, size1, start2, size2);
+
+    auto addRow = [this](const Row& row)
+    {
+        const auto width = (int)row.pixels.size();
+
+        //the analysis area changed size, start a new history
+        if (history.getWidth() != width || history.getHeight() != row.historyLength)
+        {
+            history = juce::Image(juce::Image::ARGB, width, row.historyLength, true, juce::SoftwareImageType());
+            newestRow = 0;
+        }
+
+        //the ring grows upwards, so the rows from newestRow down are newest to oldest
+        newestRow = (newestRow + history.getHeight() - 1) % history.getHeight();
+
+        juce::Image::BitmapData bitmap(history, 0, newestRow, width, 1, juce::Image::BitmapData::writeOnly);
+        std::copy(row.pixels.begin(), row.pixels.end(), reinterpret_cast<juce::PixelARGB*>(bitmap.getLinePointer(0)));
+    };
+
+    for (int i = 0; i < size1; ++i)
+        addRow(rows[start1 + i]);
+
+    for (int i = 0; i < size2; ++i)
+        addRow(rows[start2 + i]);
+
+    queue.finishedRead(size1 + size2);
+    return true;
+}
+
+void SpectrogramRenderer::draw(juce::Graphics& g, int x, int y) const
+{
+    if (history.isNull())
+        return;
 
-   /* if (shouldShowFFTAnalysis)
+    const auto width = history.getWidth();
+    const auto height = history.getHeight();
+
+    //newestRow to the bottom holds the newest rows, everything above it wrapped around and is older
+    const auto numNewer = height - newestRow;
+    g.drawImage(history, x, y, width, numNewer, 0, newestRow, width, numNewer);
+
+    if (newestRow > 0)
+        g.drawImage(history, x, y + numNewer, width, newestRow, 0, 0, width, newestRow);
+}
+
+void SpectrogramRenderer::reset()
+{
+    queue.reset();
+
+    if (history.isValid())
+        history.clear(history.getBounds());
+
+    newestRow = 0;
+}
+
+void HistoryRenderer::render(const SpectralHistory& spectralHistory, double spanSeconds, double nowSeconds,
+    int width, int height, float negativeInfinity)
+{
+    renderedVersion = spectralHistory.getVersion();
+    renderedSpan = spanSeconds;
+    renderedWidth = width;
+    renderedHeight = height;
+    renderedRow = getRow(nowSeconds, spanSeconds, height);
+
+    auto& image = imageBuffer.getWriteBuffer();
+
+    if (image.getWidth() != width || image.getHeight() != height)
+    {
+        if (width <= 0 || height <= 0)
+            return;
+
+        image = juce::Image(juce::Image::ARGB, width, height, true, juce::SoftwareImageType());
+    }
+
+    constexpr auto numBands = SpectralHistory::numBands;
+    averages.resize((size_t)height * numBands);
+    maxima.resize((size_t)height * numBands);
+
+    spectralHistory.read(spanSeconds, nowSeconds, height, averages.data(), maxima.data());
+
+    constexpr auto tableSize = SpectrogramRenderer::tableSize;
+    const auto& colourTable = SpectrogramRenderer::getColourTable();
+    const auto scale = (tableSize - 1) / -negativeInfinity;
+
+    juce::Image::BitmapData bitmap(image, juce::Image::BitmapData::writeOnly);
+
+    for (int y = 0; y < height; ++y)
     {
-        auto fftBounds = getAnalysisArea().toFloat();
-        auto sampleRate = audioProcessor.getSampleRate();
+        const auto* rowLevels = averages.data() + (size_t)y * numBands;
+        auto* pixels = reinterpret_cast<juce::PixelARGB*>(bitmap.getLinePointer(y));
+
+        //a gap: the grid shows through, so it can't be mistaken for silence
+        if (rowLevels[0] == SpectralHistory::noData)
+        {
+            std::fill(pixels, pixels + width, juce::PixelARGB(0, 0, 0, 0));
+            continue;
+        }
+
+        //the bands are log spaced over the same range as x, so band b covers [b, b + 1) * width / numBands
+        int x = 0;
+        for (int b = 0; b < numBands; ++b)
+        {
+            const auto index = juce::jlimit(0, tableSize - 1, (int)((rowLevels[b] - negativeInfinity) * scale));
+            const auto end = (b + 1) * width / numBands;
+
+            std::fill(pixels + x, pixels + end, colourTable[index]);
+            x = end;
+        }
+    }
+
+    imageBuffer.publish();
+}
+
+void SpectrumColumnMap::prepare(int fftSize, double sampleRate, int numBands, int width, int pixelsPerColumn, int smoothing)
+{
+    mappedFFTSize = fftSize;
+    mappedSampleRate = sampleRate;
+    mappedNumBands = numBands;
+    mappedWidth = width;
+    mappedPixelsPerColumn = pixelsPerColumn;
+    mappedSmoothing = smoothing;
 
-        leftPathProducer.process(fftBounds, sampleRate);
-        rightPathProducer.process(fftBounds, sampleRate);
-    }*/
+    columns.clear();
+
+    const auto numBins = fftSize / 2;
+    prefixSums.resize((size_t)numBins + 1);
+    binPowers.resize((size_t)numBins);
+
+    //a 1/N-octave window reaches half of that on either side of the centre
+    const auto smoothingRatio = smoothing > 0 ? std::pow(2.0, 0.5 / smoothing) : 1.0;
+
+    if (width <= 0 || sampleRate <= 0.0)
+        return;
+
+    auto frequencyAt = [width](double x)
+    {
+        return juce::mapToLog10(x / width, 20.0, 20000.0);
+    };
+
+    for (int x = 0; x < width; x += pixelsPerColumn)
+    {
+        const auto centre = juce::jmin(double(width), x + 0.5 * pixelsPerColumn);
+        const auto centreFrequency = frequencyAt(centre);
+
+        //the most decimated band that still reaches this high
+        int band = 0;
+        while (band + 1 < numBands && centreFrequency < bandUpperLimit * sampleRate / (1 << (band + 1)))
+            ++band;
+
+        const auto binWidth = sampleRate / (1 << band) / double(fftSize);
+        const auto centreBin = centreFrequency / binWidth;
+
+        //nothing to show above nyquist
+        if (centreBin >= numBins - 1)
+            break;
+
+        //bins in [start, end) belong to this column
+        const auto firstBin = juce::jmax(1, (int)std::ceil(frequencyAt(x) / binWidth));
+        const auto endBin = juce::jmin(numBins, (int)std::ceil(frequencyAt(x + pixelsPerColumn) / binWidth));
+
+        Column column;
+        column.x = (float)centre;
+        column.band = band;
+
+        if (endBin > firstBin)
+        {
+            column.firstBin = firstBin;
+            column.numBins = endBin - firstBin;
+        }
+        else
+        {
+            //no bin of its own, interpolate at the column's centre
+            column.firstBin = (int)std::floor(centreBin);
+            column.fraction = (float)(centreBin - column.firstBin);
+        }
+
+        if (smoothing > 0)
+        {
+            //never narrower than the column itself, so wide columns don't skip bins
+            auto start = juce::jmin(centreBin / smoothingRatio, (double)firstBin);
+            auto end = juce::jmax(centreBin * smoothingRatio, (double)endBin);
+
+            start = juce::jmax(0.0, start);
+            end = juce::jmin(double(numBins - 1), end);
+
+            //windows under a bin wide are left to the interpolation above
+            if (end - start >= 1.0)
+            {
+                column.smoothed = true;
+                column.smoothingStart = (float)start;
+                column.smoothingEnd = (float)end;
+            }
+        }
+
+        columns.push_back(column);
+    }
+}
+
+float SpectrumColumnMap::getMean(const float* bins, float start, float end) const
+{
+    //bin k covers [k - 0.5, k + 0.5), so the integral up to position p is the sum of the whole
+    //bins below p + 0.5 plus the covered part of the one it ends in
+    auto integral = [this, bins](float position)
+    {
+        position += 0.5f;
+        const auto whole = (int)position;
+        return prefixSums[whole] + (position - whole) * bins[whole];
+    };
+
+    return (float)((integral(end) - integral(start)) / (end - start));
+}
+
+void SpectrumColumnMap::reduce(const std::array<const float*, maxBands>& bandFrames,
+    float floorLevel,
+    float* columnLevels,
+    Reduction reduction)
+{
+    const auto numBins = mappedFFTSize / 2;
+    const auto inPower = reduction == Reduction::loudest;
+    int summedBand = -1;
+    const float* summedValues = nullptr;
+
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        const auto& column = columns[i];
+        const auto* frame = bandFrames[column.band];
+
+        if (frame == nullptr)
+        {
+            columnLevels[i] = floorLevel;
+            continue;
+        }
+
+        const auto meanOfBins = reduction == Reduction::mean && column.numBins > 1;
+
+        if (column.smoothed || meanOfBins)
+        {
+            //columns run from low to high, so each band's columns come in one run and its sums are built once
+            if (column.band != summedBand)
+            {
+                summedValues = frame;
+
+                if (inPower)
+                {
+                    FFTDataGenerator<std::vector<float>>::decibelsToPower(frame, binPowers.data(), numBins);
+                    summedValues = binPowers.data();
+                }
+
+                prefixSums[0] = 0.0;
+                for (int k = 0; k < numBins; ++k)
+                    prefixSums[k + 1] = prefixSums[k] + summedValues[k];
+
+                summedBand = column.band;
+            }
+
+            const auto mean = column.smoothed
+                ? getMean(summedValues, column.smoothingStart, column.smoothingEnd)
+                : (float)((prefixSums[column.firstBin + column.numBins] - prefixSums[column.firstBin]) / column.numBins);
+
+            columnLevels[i] = inPower ? 10.f * std::log10(mean) : mean;
+            continue;
+        }
+
+        const auto* bins = frame + column.firstBin;
+
+        columnLevels[i] = column.numBins > 0
+            ? juce::FloatVectorOperations::findMaximum(bins, column.numBins)
+            : bins[0] + column.fraction * (bins[1] - bins[0]);
+    }
+}
+
+AnalyzerTask::AnalyzerTask(ParametricEQAudioProcessor& p, PathProducer& producer) :
+    audioProcessor(p),
+    pathProducer(producer)
+{
+
+    scheduler->addClient(this);
+}
+
+AnalyzerTask::~AnalyzerTask()
+{
+    scheduler->removeClient(this);
+}
+
+void AnalyzerTask::setAnalysisBounds(juce::Rectangle<float> bounds)
+{
+    const juce::SpinLock::ScopedLockType lock(boundsLock);
+    analysisBounds = bounds;
+}
+
+void AnalyzerTask::resetProducer()
+{
+    //removeClient() waits for a running runAnalysis() to return
+    scheduler->removeClient(this);
+
+    pathProducer.reset();
+
+    scheduler->addClient(this);
+}
+
+void AnalyzerTask::runAnalysis()
+{
+    if (!enabled.load())
+        return;
+
+    juce::Rectangle<float> fftBounds;
+    {
+        const juce::SpinLock::ScopedLockType lock(boundsLock);
+        fftBounds = analysisBounds;
+    }
+
+    if (fftBounds.isEmpty())
+        return;
+
+    using Settings = AnalyzerSettings;
+    const auto& settings = audioProcessor.analyzerSettings;
+
+    //choice index 0, 1, 2 -> 2048, 4096, 8192
+    pathProducer.setFFTOrder(static_cast<FFTOrder>(FFTOrder::order2048 + settings.get(Settings::resolution)));
+    pathProducer.setAnalyzerMode(static_cast<AnalyzerMode>(settings.get(Settings::mode)));
+    //with 4 octave bands the finest one covers everything below 0.35 * sampleRate / 8, ~2 kHz at 48 kHz
+    pathProducer.setNumBands(settings.isOn(Settings::multiResolution) ? 4 : 1);
+
+    //choice index 0..4 -> off, 1/3, 1/6, 1/12, 1/24 octave
+    const int octaveFractions[] = { 0, 3, 6, 12, 24 };
+    pathProducer.setSmoothing(octaveFractions[settings.get(Settings::smoothing)]);
+    //choice index 0, 1, 2 -> spectrum, spectrogram, history
+    pathProducer.setView(static_cast<AnalyzerView>(settings.get(Settings::view)));
+
+    //choice index 0..4 -> 1 min, 10 min, 1 h, 6 h, 24 h
+    const double historySpans[] = { 60.0, 600.0, 3600.0, 6 * 3600.0, 24 * 3600.0 };
+    pathProducer.setHistorySpan(historySpans[settings.get(Settings::historySpan)]);
+    pathProducer.setPreEQTap(settings.isOn(Settings::preEQ));
+
+    pathProducer.process(fftBounds, audioProcessor.getSampleRate());
+}
+
+HistoryAnalyzer::HistoryAnalyzer(ParametricEQAudioProcessor& p) :
+    audioProcessor(p)
+{
+    generator.changeOrder(FFTOrder::order8192);
+
+    for (auto& buffer : windowBuffers)
+        buffer.resize((size_t)generator.getFFTSize(), 0.f);
+
+    samplesUntilNextHop = getHopSize();
+
+    scheduler->addClient(this);
+}
+
+HistoryAnalyzer::~HistoryAnalyzer()
+{
+    scheduler->removeClient(this);
+}
+
+void HistoryAnalyzer::runAnalysis()
+{
+    auto& leftFifo = audioProcessor.leftHistoryFifo;
+    auto& rightFifo = audioProcessor.rightHistoryFifo;
+
+    //the processor can't reallocate the rings while spans into them are out
+    const juce::ScopedLock leftLock(leftFifo.getResizeLock());
+    const juce::ScopedLock rightLock(rightFifo.getResizeLock());
+
+    const auto sampleRate = audioProcessor.getSampleRate();
+
+    if (!leftFifo.isPrepared() || !rightFifo.isPrepared() || sampleRate <= 0.0)
+        return;
+
+    const auto fftSize = generator.getFFTSize();
+
+    //one 1 px column per band over the display's 20 Hz - 20 kHz is exactly 1/6 octave each
+    if (!bandMap.matches(fftSize, sampleRate, 1, SpectralHistory::numBands, 1, 0))
+    {
+        bandMap.prepare(fftSize, sampleRate, 1, SpectralHistory::numBands, 1, 0);
+
+        for (auto& levels : bandLevels)
+            levels.resize(bandMap.getColumns().size());
+    }
+
+    //the audio thread fills the left fifo first, only take what both have
+    const auto numAvailable = juce::jmin(leftFifo.getNumSamplesAvailable(), rightFifo.getNumSamplesAvailable());
+
+    std::array<SampleRing::Spans, 2> spans;
+    spans[Channel::Left] = leftFifo.readSamples(numAvailable);
+    spans[Channel::Right] = rightFifo.readSamples(numAvailable);
+
+    int offset = 0;
+    while (offset < numAvailable)
+    {
+        //stop at the rings' ends, the window's end and the next hop, whichever comes first
+        auto num = juce::jmin(numAvailable - offset, samplesUntilNextHop, fftSize - writeIndex);
+
+        std::array<const float*, 2> signals;
+        for (auto channel : { Channel::Left, Channel::Right })
+        {
+            int numContiguous;
+            signals[channel] = getSpanData(spans[channel], offset, numContiguous);
+            num = juce::jmin(num, numContiguous);
+        }
+
+        for (auto channel : { Channel::Left, Channel::Right })
+            juce::FloatVectorOperations::copy(windowBuffers[channel].data() + writeIndex, signals[channel], num);
+
+        writeIndex = (writeIndex + num) % fftSize;
+        samplesUntilNextHop -= num;
+        offset += num;
+
+        if (samplesUntilNextHop == 0)
+        {
+            //nobody pulls the generator's mailbox, the frames go straight into the history
+            generator.produceFFTDataForRendering(windowBuffers[Channel::Left].data(),
+                windowBuffers[Channel::Right].data(),
+                nullptr,
+                nullptr,
+                writeIndex,
+                -48.f,
+                [this](const float* left, const float* right, int) { addToHistory(left, right); });
+            samplesUntilNextHop = getHopSize();
+        }
+    }
+
+    leftFifo.finishedReading(numAvailable);
+    rightFifo.finishedReading(numAvailable);
+}
+
+void HistoryAnalyzer::addToHistory(const float* left, const float* right)
+{
+    std::array<const float*, SpectrumColumnMap::maxBands> bandFrames {};
+
+    bandFrames[0] = left;
+    bandMap.reduce(bandFrames, -48.f, bandLevels[Channel::Left].data());
+    bandFrames[0] = right;
+    bandMap.reduce(bandFrames, -48.f, bandLevels[Channel::Right].data());
+
+    //the louder channel, like the spectrogram. bands above nyquist have no column.
+    const auto numMapped = (int)bandMap.getColumns().size();
+    juce::FloatVectorOperations::max(historyLevels.data(),
+        bandLevels[Channel::Left].data(),
+        bandLevels[Channel::Right].data(),
+        numMapped);
+    std::fill(historyLevels.begin() + numMapped, historyLevels.end(), -48.f);
+
+    audioProcessor.spectralHistory.addFrame(historyLevels.data(), SpectralHistory::getCurrentTime());
+}
+
+void ResponseCurveComponent::timerCallback() {
+
+    //the analyzer thread did the work, only pick up its finished paths here
+    if (shouldShowFFTAnalysis)
+    {
+        if (pathProducer.pullImage())
+            repaint();
+    }
 
     if (parametersChanged.compareAndSetBool(false, true))
     {
@@ -350,6 +1473,126 @@ void ResponseCurveComponent::timerCallback() {
         //updateResponseCurve();
     }
 
+    //numbers changing faster than ~15 times a second can't be read anyway
+    meterRefreshCounter = (meterRefreshCounter + 1) % 4;
+    if (meterRefreshCounter == 0)
+        meter.repaint();
+
+    //the recorder opens its file on its own thread, so a failure only shows up later
+    if (pathProducer.getRecorder().checkOpenFailure() && recordingChooser != nullptr)
+    {
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Record Analyzer",
+            "Couldn't open " + recordingChooser->getResult().getFullPathName() + " for writing.");
+    }
+
+}
+
+void ResponseCurveComponent::mouseDown(const juce::MouseEvent& e)
+{
+    if (!e.mods.isPopupMenu())
+        return;
+
+    juce::Component::SafePointer<ResponseCurveComponent> safeThis(this);
+    juce::PopupMenu menu;
+
+    if (pathProducer.getRecorder().isRecording())
+    {
+        const auto numDropped = pathProducer.getRecorder().getNumDroppedFrames();
+        juce::String stopItem("Stop Recording Analyzer");
+        if (numDropped > 0)
+            stopItem += " (" + juce::String(numDropped) + " frames dropped)";
+
+        menu.addItem(stopItem, [safeThis]
+        {
+            if (safeThis == nullptr)
+                return;
+
+            auto& recorder = safeThis->pathProducer.getRecorder();
+            recorder.stop();
+
+            //the writer may still drop a few while it drains, this is what it had dropped so far
+            if (const auto numDroppedNow = recorder.getNumDroppedFrames(); numDroppedNow > 0)
+            {
+                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Record Analyzer",
+                    juce::String(numDroppedNow) + " analyzer frames were dropped from the recording, "
+                    "because the disk couldn't keep up or the resolution changed while recording.");
+            }
+        });
+    }
+    else
+    {
+        menu.addItem("Record Analyzer...", [safeThis]
+        {
+            if (safeThis != nullptr)
+                safeThis->chooseRecordingFile(false);
+        });
+        menu.addItem("Record Analyzer (float16)...", [safeThis]
+        {
+            if (safeThis != nullptr)
+                safeThis->chooseRecordingFile(true);
+        });
+    }
+
+    menu.addSeparator();
+
+    //the analyzer's display options, a submenu for each choice and a tick for each on/off one
+    using Settings = AnalyzerSettings;
+    auto& settings = audioProcessor.analyzerSettings;
+
+    for (auto setting : { Settings::view, Settings::resolution, Settings::mode, Settings::smoothing, Settings::historySpan })
+    {
+        const auto& info = Settings::getInfo(setting);
+        juce::PopupMenu subMenu;
+
+        for (int i = 0; i < info.choices.size(); ++i)
+            subMenu.addItem(info.choices[i], true, settings.get(setting) == i, [&settings, setting, i] { settings.set(setting, i); });
+
+        menu.addSubMenu(info.name.fromFirstOccurrenceOf("Analyzer ", false, false), subMenu);
+    }
+
+    for (auto setting : { Settings::multiResolution, Settings::preEQ })
+    {
+        const auto& info = Settings::getInfo(setting);
+        const auto isOn = settings.isOn(setting);
+
+        menu.addItem(info.name.fromFirstOccurrenceOf("Analyzer ", false, false), true, isOn,
+            [&settings, setting, isOn] { settings.set(setting, isOn ? 0 : 1); });
+    }
+
+    menu.addSeparator();
+
+    const auto truePeakOn = settings.isOn(Settings::truePeak);
+    menu.addItem("Measure True Peak", true, truePeakOn,
+        [&settings, truePeakOn] { settings.set(Settings::truePeak, truePeakOn ? 0 : 1); });
+
+    auto& loudness = audioProcessor.loudnessMeter;
+    menu.addItem("Reset Loudness", [&loudness] { loudness.requestReset(); });
+
+    menu.showMenuAsync(juce::PopupMenu::Options());
+}
+
+void ResponseCurveComponent::chooseRecordingFile(bool quantiseToFloat16)
+{
+    recordingChooser = std::make_unique<juce::FileChooser>("Record Analyzer To",
+        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("analyzer.peqspec"),
+        "*.peqspec");
+
+    const auto flags = juce::FileChooser::saveMode | juce::FileChooser::canSelectFiles | juce::FileChooser::warnAboutOverwriting;
+
+    //the chooser is owned by this component, so it can't call back after it's gone
+    recordingChooser->launchAsync(flags, [this, quantiseToFloat16](const juce::FileChooser& chooser)
+    {
+        const auto file = chooser.getResult();
+
+        if (file == juce::File())
+            return;
+
+        if (!pathProducer.getRecorder().start(file, quantiseToFloat16))
+        {
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Record Analyzer",
+                "The last recording is still being written to disk. Try again in a moment.");
+        }
+    });
 }
 
 juce::Rectangle<int> ResponseCurveComponent::getRenderArea()
@@ -405,7 +1648,11 @@ std::vector<float> ResponseCurveComponent::getXs(const std::vector<float>& freqs
 void ResponseCurveComponent::resized() {
     
     using namespace juce;
-    background = Image(Image::PixelFormat::RGB, getWidth(), getHeight(), false);
+    analyzerTask.setAnalysisBounds(getAnalysisArea().toFloat());
+    meter.setBounds(getMeterArea());
+
+    //cleared, the meter's fill has to match what's behind the grid lines
+    background = Image(Image::PixelFormat::RGB, getWidth(), getHeight(), true);
     Graphics g(background);
   
     auto freqs = getFrequencies();
@@ -445,21 +1692,6 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
 
     //-------------------------------------------------------------
 
-     if( shouldShowFFTAnalysis )
-    {
-        auto leftChannelFFTPath = leftPathProducer.getPath();
-        leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
-        
-        g.setColour(Colour(97u, 18u, 167u)); //purple-
-        g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
-        
-        auto rightChannelFFTPath = rightPathProducer.getPath();
-        rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
-        
-        g.setColour(Colour(215u, 201u, 134u));
-        g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
-    }
-    
     g.setColour(Colours::white);
     g.strokePath(responseCurve, PathStrokeType(2.f));
     
@@ -476,6 +1708,19 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
     //==========================================================
 
     g.drawImage(background, getLocalBounds().toFloat());
+
+    //on top of the opaque grid, not underneath it
+    if (shouldShowFFTAnalysis)
+    {
+        //the analyzer thread already rendered the spectrum, just blit it
+        auto analysisArea = getAnalysisArea();
+
+        if (pathProducer.getView() == spectrogramView)
+            pathProducer.getSpectrogram().draw(g, analysisArea.getX(), analysisArea.getY());
+        else
+            g.drawImageAt(pathProducer.getImage(), analysisArea.getX(), analysisArea.getY());
+    }
+
     responseArea = getRenderArea();
 
     auto w = responseArea.getWidth();
@@ -548,7 +1793,56 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
     g.drawRect(responseArea.toFloat(),3.f);
     g.setColour(Colours::black);
     g.strokePath(responseCurve, PathStrokeType(1.5f));
+}
+
+juce::Rectangle<int> ResponseCurveComponent::getMeterArea()
+{
+    return getAnalysisArea().reduced(4).removeFromTop(24).removeFromLeft(260);
+}
+
+MeterComponent::MeterComponent(ParametricEQAudioProcessor& p) : audioProcessor(p)
+{
+    setOpaque(true);
+}
+
+void MeterComponent::paint(juce::Graphics& g)
+{
+    using namespace juce;
+
+    //the same black as the grid behind the analyzer
+    g.fillAll(Colours::black);
+
+    const auto& meter = audioProcessor.outputMeter;
+
+    auto toText = [](float gain)
+    {
+        return gain > 0.f ? String(Decibels::gainToDecibels(gain), 1) : String("-inf");
+    };
+
+    const auto text = "Peak " + toText(meter.getPeak(0)) + " / " + toText(meter.getPeak(1))
+        + "  RMS " + toText(meter.getRMS(0)) + " / " + toText(meter.getRMS(1))
+        + "  Corr " + String(meter.getCorrelation(), 2);
+
+    const auto& loudness = audioProcessor.loudnessMeter;
+
+    auto toLUFS = [](float lufs)
+    {
+        return std::isfinite(lufs) ? String(lufs, 1) : String("-inf");
+    };
+
+    auto loudnessText = "M " + toLUFS(loudness.getMomentary()) + "  S " + toLUFS(loudness.getShortTerm())
+        + "  I " + toLUFS(loudness.getIntegrated()) + " LUFS";
+
+    if (audioProcessor.analyzerSettings.isOn(AnalyzerSettings::truePeak))
+        loudnessText += "  TP " + toLUFS(loudness.getTruePeak()) + " dBTP ("
+            + String(loudness.getTruePeakLoad() * 100.f, 1) + "% CPU)";
+
+    auto area = getLocalBounds();
 
+    g.setColour(Colours::lightgrey);
+    g.setFont(10);
+    g.drawFittedText(text, area.removeFromTop(12), Justification::centredLeft, 1);
+    g.drawFittedText(loudnessText, area, Justification::centredLeft, 1);
 }
 
 //==============================================================================
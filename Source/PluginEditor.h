@@ -10,182 +10,1152 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "HalfBandDecimator.h"
+#include "AnalyzerTables.h"
+#include "AnalyzerScheduler.h"
+#include "SpectrumRecorder.h"
+#include "SpectralHistory.h"
+
+//the analyzer's channel separation runs four bins per step on 128 bit registers where there are some
+#if JUCE_USE_SIMD && defined (__SSE2__)
+ #define PARAMETRICEQ_SSE_SEPARATION 1
+ #include <emmintrin.h>
+#elif JUCE_USE_SIMD && (defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64))
+ #define PARAMETRICEQ_NEON_SEPARATION 1
+ #include <arm_neon.h>
+#endif
 
 enum FFTOrder
 {
+    order512 = 9,   //only used when the QualityGovernor cuts the analyzer back
+    order1024 = 10,
     order2048 = 11,
     order4096 = 12,
     order8192 = 13
 };
 
+//what the analyzer shows. same order as the AnalyzerSettings::mode choices
+enum AnalyzerMode
+{
+    raw,
+    average,
+    peakHold,
+    maxHold
+};
+
+//what the analysis area draws. same order as the AnalyzerSettings::view choices
+enum AnalyzerView
+{
+    spectrumView,
+    spectrogramView,
+    historyView
+};
+
+/**
+ produces the spectra of both channels with a single complex FFT.
+ L goes into the real part and R into the imaginary part, and the two spectra are
+ separated afterwards using the conjugate symmetry of a real signal's spectrum:
+ L[k] = (Z[k] + conj(Z[N-k])) / 2,  R[k] = (Z[k] - conj(Z[N-k])) / 2i
+ with a pre-EQ tap the pre-EQ channels go through a second FFT of the same plan,
+ and each frame also carries the post - pre difference.
+ */
 template<typename BlockType>
 struct FFTDataGenerator
 {
+    //Channel::Right, Channel::Left, then the difference
+    static constexpr int differenceIndex = 2;
+    using Frame = std::array<BlockType, 3>;
+
+    static constexpr int minOrder = FFTOrder::order512;
+    static constexpr int maxOrder = FFTOrder::order8192;
+    static constexpr int maxFFTSize = 1 << maxOrder;
+
+    //a plan that hasn't been used for this long is freed
+    static constexpr juce::uint32 planReleaseDelayMs = 10000;
+
+    FFTDataGenerator()
+    {
+        //frames are sized for the largest order once, so switching never touches the mailbox
+        fftDataBuffer.prepare([](Frame& frame)
+        {
+            for (auto& buffer : frame)
+                buffer.resize(maxFFTSize / 2, 0);
+        });
+
+        //same for the averaging and hold state
+        for (auto& state : outputStates)
+            state.resize(maxFFTSize / 2, 0);
+    }
+
+    /**
+     how frames are smoothed before they're published. 'averagingCoefficient' (0..1) and
+     'peakDecayPerFrame' (dB) apply once per frame, so they depend on the hop size.
+     switching modes starts the new mode from the current frame.
+     */
+    void setOutputStage(AnalyzerMode newMode, float newAveragingCoefficient, float newPeakDecayPerFrame)
+    {
+        if (newMode != mode)
+            needsStateReset = true;
+
+        mode = newMode;
+        averagingCoefficient = newAveragingCoefficient;
+        peakDecayPerFrame = newPeakDecayPerFrame;
+    }
+
+    //starts averaging and holding over from the next frame
+    void resetOutputStage() { needsStateReset = true; }
+
     /**
-     produces the FFT data from an audio buffer.
+     produces the FFT data from circular window buffers.
+     all hold the last getFFTSize() samples of their channel, the oldest one at 'oldestIndex'.
+     the pre-EQ buffers are nullptr when there's no pre-EQ tap, the frame then has no difference.
+     'handleFrame' (left, right, numBins) sees every frame before it's published, while the
+     mailbox only keeps whichever one is newest when the reader gets to it.
      */
-    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    template<typename FrameHandler>
+    void produceFFTDataForRendering(const float* leftBuffer,
+        const float* rightBuffer,
+        const float* preLeftBuffer,
+        const float* preRightBuffer,
+        int oldestIndex,
+        const float negativeInfinity,
+        FrameHandler&& handleFrame)
     {
         const auto fftSize = getFFTSize();
 
-        fftData.assign(fftData.size(), 0);
-        auto* readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
+        auto& plan = *currentPlan;
+        transform(plan, leftBuffer, rightBuffer, oldestIndex, plan.packedSpectrum);
 
-        // first apply a windowing function to our data
-        window->multiplyWithWindowingTable(fftData.data(), fftSize);       // [1]
+        //the frame is rendered straight into the mailbox slot the reader isn't using
+        auto& frame = fftDataBuffer.getWriteBuffer();
+        auto* left = frame[Channel::Left].data();
+        auto* right = frame[Channel::Right].data();
 
-        // then render our FFT data..
-        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());  // [2]
+        const int numBins = (int)fftSize / 2;
+        const auto* spectrum = reinterpret_cast<const float*>(plan.packedSpectrum.data());
 
-        int numBins = (int)fftSize / 2;
+        //normalises |2L|^2 to (|L| / numBins)^2, see separateToDecibels
+        const auto powerScale = juce::square(0.5f / float(numBins));
+        //anything at or below this (and NaNs) ends up at 'negativeInfinity'
+        const auto floorPower = std::pow(10.f, negativeInfinity / 10.f);
 
-        //normalize the fft values.
-        for (int i = 0; i < numBins; ++i)
-        {
-            auto v = fftData[i];
-            //            fftData[i] /= (float) numBins;
-            if (!std::isinf(v) && !std::isnan(v))
-            {
-                v /= float(numBins);
-            }
-            else
-            {
-                v = 0.f;
-            }
-            fftData[i] = v;
-        }
+        separateToDecibels(spectrum, left, right, fftSize, powerScale, floorPower);
 
-        //convert them to decibels
-        for (int i = 0; i < numBins; ++i)
+        if (preLeftBuffer != nullptr && preRightBuffer != nullptr)
         {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
+            transform(plan, preLeftBuffer, preRightBuffer, oldestIndex, plan.packedPreSpectrum);
+
+            auto* difference = frame[differenceIndex].data();
+            separateToDifference(reinterpret_cast<const float*>(plan.packedPreSpectrum.data()),
+                left, right, difference, fftSize, powerScale, floorPower);
+
+            //holding peaks of a difference would show gains the EQ never applied, so it's only ever averaged
+            if (mode != AnalyzerMode::raw)
+                applyAveraging(difference, outputStates[differenceIndex].data(), numBins);
         }
 
-        fftDataFifo.push(fftData);
+        applyOutputStage(left, outputStates[Channel::Left].data(), numBins);
+        applyOutputStage(right, outputStates[Channel::Right].data(), numBins);
+        needsStateReset = false;
+
+        handleFrame(left, right, numBins);
+        fftDataBuffer.publish();
     }
 
+    /**
+     switches to another order. each order's plan is set up the first time it's used and kept around
+     afterwards, so switching back and forth doesn't allocate. its window comes from the
+     process-wide AnalyzerTables, so it's only built if no other analyzer has built it yet.
+     */
     void changeOrder(FFTOrder newOrder)
     {
-        //when you change order, recreate the window, forwardFFT, fifo, fftData
-        //also reset the fifoIndex
-        //things that need recreating should be created on the heap via std::make_unique<>
+        jassert(minOrder <= newOrder && newOrder <= maxOrder);
 
         order = newOrder;
-        auto fftSize = getFFTSize();
 
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+        auto& plan = plans[order - minOrder];
+        if (plan == nullptr)
+            plan = std::make_unique<Plan>(order);
+
+        currentPlan = plan.get();
+        currentPlan->lastUsed = juce::Time::getMillisecondCounter();
+
+        //a frame still waiting in the mailbox was rendered at the old size
+        fftDataBuffer.pull();
+
+        //and the bins mean different frequencies now
+        needsStateReset = true;
+    }
 
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
+    /**
+     frees the plans of orders that haven't been used for planReleaseDelayMs.
+     */
+    void releaseUnusedPlans()
+    {
+        const auto now = juce::Time::getMillisecondCounter();
+        currentPlan->lastUsed = now;
 
-        fftDataFifo.prepare(fftData.size());
+        for (auto& plan : plans)
+        {
+            if (plan != nullptr && plan.get() != currentPlan && now - plan->lastUsed > planReleaseDelayMs)
+                plan.reset();
+        }
     }
     //==============================================================================
     int getFFTSize() const { return 1 << order; }
-    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
+    FFTOrder getOrder() const { return order; }
     //==============================================================================
-    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+    /**
+     makes the newest frame available through getFFTData(). returns false if there is no new frame.
+     */
+    bool pullFFTData() { return fftDataBuffer.pull(); }
+    const BlockType& getFFTData(Channel channel) const { return fftDataBuffer.getReadBuffer()[channel]; }
+    //post - pre in dB, only meaningful for frames produced with a pre-EQ tap
+    const BlockType& getDifferenceData() const { return fftDataBuffer.getReadBuffer()[differenceIndex]; }
+
+    /**
+     10^(dB / 10) for 'numValues' levels, the way back from the frames' dB for anything averaging them
+     as power. four per step where there's SSE2 or NEON, the tail and other targets give the same results.
+     within 0.00002 dB of the exact value, levels under about -380 dB come out as that floor.
+     */
+    static void decibelsToPower(const float* decibels, float* power, int numValues)
+    {
+        int i = 0;
+       #if PARAMETRICEQ_SSE_SEPARATION || PARAMETRICEQ_NEON_SEPARATION
+        const auto log2Of10Over10 = expand(log2Of10 / 10.f);
+        for (; i + 4 <= numValues; i += 4)
+        {
+            FloatVector fraction, powerOfTwo;
+            splitPowerOfTwo(multiply(load(decibels + i), log2Of10Over10), fraction, powerOfTwo);
+
+            auto exp2Fraction = expand(exp2Coefficients[5]);
+            for (int c = 4; c >= 0; --c)
+                exp2Fraction = add(multiply(exp2Fraction, fraction), expand(exp2Coefficients[c]));
+
+            store(power + i, multiply(exp2Fraction, powerOfTwo));
+        }
+       #endif
+
+        for (; i < numValues; ++i)
+            power[i] = decibelsToPower(decibels[i]);
+    }
 private:
-    FFTOrder order;
-    BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    /**
+     updates the current mode's state from 'frame' and replaces 'frame' with it.
+     only the active mode's state is kept up to date, the others are restarted when switched to.
+     */
+    void applyOutputStage(float* frame, float* state, int numBins)
+    {
+        using FVO = juce::FloatVectorOperations;
 
-    Fifo<BlockType> fftDataFifo;
-};
+        if (mode == AnalyzerMode::raw)
+            return;
 
-template<typename PathType>
-struct AnalyzerPathGenerator
-{
-    /*
-     converts 'renderData[]' into a juce::Path
+        if (needsStateReset)
+        {
+            FVO::copy(state, frame, numBins);
+            return;
+        }
+
+        switch (mode)
+        {
+        case AnalyzerMode::average:
+            applyAveraging(frame, state, numBins);
+            return;
+        case AnalyzerMode::peakHold:
+            FVO::add(state, -peakDecayPerFrame, numBins);
+            FVO::max(state, state, frame, numBins);
+            break;
+        case AnalyzerMode::maxHold:
+            FVO::max(state, state, frame, numBins);
+            break;
+        case AnalyzerMode::raw:
+            break;
+        }
+
+        FVO::copy(frame, state, numBins);
+    }
+
+    //state += a * (frame - state), then frame = state
+    void applyAveraging(float* frame, float* state, int numBins)
+    {
+        using FVO = juce::FloatVectorOperations;
+
+        if (needsStateReset)
+        {
+            FVO::copy(state, frame, numBins);
+            return;
+        }
+
+        FVO::multiply(state, 1.f - averagingCoefficient, numBins);
+        FVO::addWithMultiply(state, frame, averagingCoefficient, numBins);
+        FVO::copy(frame, state, numBins);
+    }
+
+    AnalyzerMode mode = AnalyzerMode::raw;
+    float averagingCoefficient = 1.f;
+    float peakDecayPerFrame = 0.f;
+    bool needsStateReset = true;
+    std::array<std::vector<float>, 3> outputStates;
+
+    /**
+     separates a packed spectrum of two real channels and converts it to dB, staying in the power domain:
+     |2L|^2 = |Z[k] + conj(Z[N-k])|^2, |2R|^2 = |Z[k] - conj(Z[N-k])|^2
+     gainToDecibels(|L| / numBins) == 10 * log10(|2L|^2 * (0.5 / numBins)^2), no sqrt needed.
+
+     the mirrored bins N - k run backwards, so they're read as a contiguous block ending at N - k and
+     reversed in registers instead of gathered one by one. four bins per step where there's SSE2 or NEON,
+     the scalar tail and other targets give the same results.
      */
-    void generatePath(const std::vector<float>& renderData,
-        juce::Rectangle<float> fftBounds,
-        int fftSize,
-        float binWidth,
-        float negativeInfinity)
+    static void separateToDecibels(const float* spectrum, float* left, float* right, int fftSize,
+        float powerScale, float floorPower)
     {
-        auto top = fftBounds.getY();
-        auto bottom = fftBounds.getHeight();
-        auto width = fftBounds.getWidth();
+        const int numBins = fftSize / 2;
 
-        int numBins = (int)fftSize / 2;
+        //bin 0 is its own mirror, which would make the block below run past the end
+        separateBin(spectrum, 0, 0, powerScale, floorPower, left[0], right[0]);
 
-        PathType p;
-        p.preallocateSpace(3 * (int)fftBounds.getWidth());
+        int k = 1;
+       #if PARAMETRICEQ_SSE_SEPARATION || PARAMETRICEQ_NEON_SEPARATION
+        for (; k + 4 <= numBins; k += 4)
+        {
+            FloatVector leftLevels, rightLevels;
+            separateFourBins(spectrum, k, fftSize, powerScale, floorPower, leftLevels, rightLevels);
+            store(left + k, leftLevels);
+            store(right + k, rightLevels);
+        }
+       #endif
 
-        auto map = [bottom, top, negativeInfinity](float v)
+        for (; k < numBins; ++k)
+            separateBin(spectrum, k, fftSize - k, powerScale, floorPower, left[k], right[k]);
+    }
+
+    /**
+     separates the pre-EQ spectrum the same way and writes the mean of both channels' post - pre,
+     'left' and 'right' being the post-EQ levels. the pre-EQ levels only ever live in registers.
+     */
+    static void separateToDifference(const float* preSpectrum, const float* left, const float* right,
+        float* difference, int fftSize, float powerScale, float floorPower)
+    {
+        const int numBins = fftSize / 2;
+
+        auto differenceAt = [&](int k, int m)
         {
-            return juce::jmap(v,
-                negativeInfinity, 0.f,
-                float(bottom + 10), top);
+            float preLeft, preRight;
+            separateBin(preSpectrum, k, m, powerScale, floorPower, preLeft, preRight);
+            difference[k] = 0.5f * ((left[k] - preLeft) + (right[k] - preRight));
         };
 
-        auto y = map(renderData[0]);
+        differenceAt(0, 0);
+
+        int k = 1;
+       #if PARAMETRICEQ_SSE_SEPARATION || PARAMETRICEQ_NEON_SEPARATION
+        const auto half = expand(0.5f);
+        for (; k + 4 <= numBins; k += 4)
+        {
+            FloatVector preLeft, preRight;
+            separateFourBins(preSpectrum, k, fftSize, powerScale, floorPower, preLeft, preRight);
+            store(difference + k, multiply(half, add(subtract(load(left + k), preLeft),
+                                                     subtract(load(right + k), preRight))));
+        }
+       #endif
+
+        for (; k < numBins; ++k)
+            differenceAt(k, fftSize - k);
+    }
+
+    //one bin of separateToDecibels, 'm' being its mirror N - k
+    static void separateBin(const float* spectrum, int k, int m, float powerScale, float floorPower,
+        float& left, float& right)
+    {
+        left = powerToDecibels(getPower(spectrum, k, m, 1.f) * powerScale, floorPower);
+        right = powerToDecibels(getPower(spectrum, k, m, -1.f) * powerScale, floorPower);
+    }
 
-        //        jassert( !std::isnan(y) && !std::isinf(y) );
-        if (std::isnan(y) || std::isinf(y))
-            y = bottom;
+    /**
+     |2L[k]|^2 for sign = 1, |2R[k]|^2 for sign = -1, from a packed spectrum. 'm' is the mirrored bin N - k.
+     */
+    static float getPower(const float* spectrum, int k, int m, float sign)
+    {
+        const auto re = spectrum[2 * k], im = spectrum[2 * k + 1];
+        const auto mirroredRe = sign * spectrum[2 * m], mirroredIm = -sign * spectrum[2 * m + 1];
 
-        p.startNewSubPath(0, y);
+        return juce::square(re + mirroredRe) + juce::square(im + mirroredIm);
+    }
 
-        const int pathResolution = 2; //you can draw line-to's every 'pathResolution' pixels.
+    //log2(m) for m in [sqrt(0.5), sqrt(2)) as a polynomial in x = m - 1, fitted on Chebyshev nodes
+    static constexpr float log2Coefficients[] { -1.6958884e-06f, 1.4427095f, -0.72102095f, 0.47958777f,
+                                                -0.36936922f, 0.31991413f, -0.19654828f };
 
-        for (int binNum = 1; binNum < numBins; binNum += pathResolution)
-        {
-            y = map(renderData[binNum]);
+    //2^x for x in [0, 1), fitted on Chebyshev nodes
+    static constexpr float exp2Coefficients[] { 0.99999990f, 0.69315449f, 0.24014182f, 0.055860337f,
+                                                0.0089495904f, 0.0018937541f };
+    static constexpr float log2Of10 = 3.3219280948873623f;
+
+    //one value of decibelsToPower(). 2^y split into 2^floor(y), built straight from its exponent bits, and a polynomial
+    static float decibelsToPower(float decibels)
+    {
+        const auto y = juce::jlimit(-126.f, 127.f, decibels * (log2Of10 / 10.f));
+        const auto whole = std::floor(y);
+        const auto fraction = y - whole;
+
+        const std::int32_t powerOfTwoBits = ((std::int32_t)whole + 127) << 23;
+        float powerOfTwo;
+        std::memcpy(&powerOfTwo, &powerOfTwoBits, sizeof(powerOfTwo));
+
+        auto exp2Fraction = exp2Coefficients[5];
+        for (int c = 4; c >= 0; --c)
+            exp2Fraction = exp2Fraction * fraction + exp2Coefficients[c];
+
+        return exp2Fraction * powerOfTwo;
+    }
+
+    /**
+     10 * log10(power), floored at 'floorPower'. infinities and NaNs come out as the floor.
+     log2 is taken from the float's exponent plus a polynomial on the mantissa, moved into
+     [sqrt(0.5), sqrt(2)). the error stays below 0.00001 dB over the whole float range.
+     */
+    static float powerToDecibels(float power, float floorPower)
+    {
+        //selects instead of branches. a NaN fails both comparisons and lands on the floor.
+        power = power < std::numeric_limits<float>::infinity() ? power : 0.f;
+        power = power > floorPower ? power : floorPower;
+
+        std::int32_t bits;
+        std::memcpy(&bits, &power, sizeof(bits));
+
+        //0x3f3504f3 is sqrt(0.5)
+        const auto exponent = (bits - 0x3f3504f3) >> 23;
+        const std::int32_t mantissaBits = bits - (exponent << 23);
+
+        float mantissa;
+        std::memcpy(&mantissa, &mantissaBits, sizeof(mantissa));
+
+        const auto x = mantissa - 1.f;
+        auto log2Mantissa = log2Coefficients[6];
+        for (int i = 5; i >= 0; --i)
+            log2Mantissa = log2Mantissa * x + log2Coefficients[i];
 
-            //            jassert( !std::isnan(y) && !std::isinf(y) );
+        //10 * log10(2)
+        return 3.0102999566398120f * ((float)exponent + log2Mantissa);
+    }
+
+   #if PARAMETRICEQ_SSE_SEPARATION
+    using FloatVector = __m128;
+
+    //de-interleaves bins k..k+3 and their mirrors N-k..N-k-3, lane j holding bin k + j and N - k - j
+    static void loadBins(const float* spectrum, int k, int fftSize,
+        FloatVector& re, FloatVector& im, FloatVector& mirroredRe, FloatVector& mirroredIm)
+    {
+        const auto lower = _mm_loadu_ps(spectrum + 2 * k), upper = _mm_loadu_ps(spectrum + 2 * k + 4);
+        re = _mm_shuffle_ps(lower, upper, _MM_SHUFFLE(2, 0, 2, 0));
+        im = _mm_shuffle_ps(lower, upper, _MM_SHUFFLE(3, 1, 3, 1));
+
+        //the block holds N-k-3, N-k-2 | N-k-1, N-k. picking from the top down reverses it.
+        const auto* mirrored = spectrum + 2 * (fftSize - k - 3);
+        const auto mirroredLower = _mm_loadu_ps(mirrored), mirroredUpper = _mm_loadu_ps(mirrored + 4);
+        mirroredRe = _mm_shuffle_ps(mirroredUpper, mirroredLower, _MM_SHUFFLE(0, 2, 0, 2));
+        mirroredIm = _mm_shuffle_ps(mirroredUpper, mirroredLower, _MM_SHUFFLE(1, 3, 1, 3));
+    }
+
+    static FloatVector expand(float value) { return _mm_set1_ps(value); }
+    static FloatVector add(FloatVector a, FloatVector b) { return _mm_add_ps(a, b); }
+    static FloatVector subtract(FloatVector a, FloatVector b) { return _mm_sub_ps(a, b); }
+    static FloatVector multiply(FloatVector a, FloatVector b) { return _mm_mul_ps(a, b); }
+    static FloatVector load(const float* source) { return _mm_loadu_ps(source); }
+    static void store(float* dest, FloatVector v) { _mm_storeu_ps(dest, v); }
+
+    //the selects of the scalar version. the NaN lanes fail the comparison and are zeroed before the max.
+    static FloatVector clampPower(FloatVector power, FloatVector floorPower)
+    {
+        const auto finite = _mm_cmplt_ps(power, expand(std::numeric_limits<float>::infinity()));
+        return _mm_max_ps(_mm_and_ps(power, finite), floorPower);
+    }
+
+    //the exponent and mantissa split of powerToDecibels, bit casts included
+    static void splitExponent(FloatVector power, FloatVector& exponent, FloatVector& mantissa)
+    {
+        const auto bits = _mm_castps_si128(power);
+        const auto exponentBits = _mm_srai_epi32(_mm_sub_epi32(bits, _mm_set1_epi32(0x3f3504f3)), 23);
+        mantissa = _mm_castsi128_ps(_mm_sub_epi32(bits, _mm_slli_epi32(exponentBits, 23)));
+        exponent = _mm_cvtepi32_ps(exponentBits);
+    }
+
+    //the floor and fraction split of decibelsToPower, 'y' clamped to the normal exponents
+    static void splitPowerOfTwo(FloatVector y, FloatVector& fraction, FloatVector& powerOfTwo)
+    {
+        y = _mm_min_ps(_mm_max_ps(y, expand(-126.f)), expand(127.f));
+
+        //truncation rounds negative values up, a true compare mask is -1 and takes them down to the floor
+        auto whole = _mm_cvttps_epi32(y);
+        whole = _mm_add_epi32(whole, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(whole), y)));
+
+        fraction = _mm_sub_ps(y, _mm_cvtepi32_ps(whole));
+        powerOfTwo = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23));
+    }
+   #elif PARAMETRICEQ_NEON_SEPARATION
+    using FloatVector = float32x4_t;
 
-            if (!std::isnan(y) && !std::isinf(y))
-            {
-                auto binFreq = binNum * binWidth;
-                auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
-                int binX = std::floor(normalizedBinX * width);
-                p.lineTo(binX, y);
-            }
+    //de-interleaves bins k..k+3 and their mirrors N-k..N-k-3, lane j holding bin k + j and N - k - j
+    static void loadBins(const float* spectrum, int k, int fftSize,
+        FloatVector& re, FloatVector& im, FloatVector& mirroredRe, FloatVector& mirroredIm)
+    {
+        const auto bins = vld2q_f32(spectrum + 2 * k);
+        re = bins.val[0];
+        im = bins.val[1];
+
+        //the block holds N-k-3..N-k, reversed by swapping within and then across the halves
+        const auto mirrored = vld2q_f32(spectrum + 2 * (fftSize - k - 3));
+        const auto reverse = [](float32x4_t v) { v = vrev64q_f32(v); return vcombine_f32(vget_high_f32(v), vget_low_f32(v)); };
+        mirroredRe = reverse(mirrored.val[0]);
+        mirroredIm = reverse(mirrored.val[1]);
+    }
+
+    static FloatVector expand(float value) { return vdupq_n_f32(value); }
+    static FloatVector add(FloatVector a, FloatVector b) { return vaddq_f32(a, b); }
+    static FloatVector subtract(FloatVector a, FloatVector b) { return vsubq_f32(a, b); }
+    static FloatVector multiply(FloatVector a, FloatVector b) { return vmulq_f32(a, b); }
+    static FloatVector load(const float* source) { return vld1q_f32(source); }
+    static void store(float* dest, FloatVector v) { vst1q_f32(dest, v); }
+
+    //the selects of the scalar version. the NaN lanes fail the comparison and are zeroed before the max.
+    static FloatVector clampPower(FloatVector power, FloatVector floorPower)
+    {
+        const auto finite = vcltq_f32(power, expand(std::numeric_limits<float>::infinity()));
+        const auto zeroed = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(power), finite));
+        return vmaxq_f32(zeroed, floorPower);
+    }
+
+    //the exponent and mantissa split of powerToDecibels, bit casts included
+    static void splitExponent(FloatVector power, FloatVector& exponent, FloatVector& mantissa)
+    {
+        const auto bits = vreinterpretq_s32_f32(power);
+        const auto exponentBits = vshrq_n_s32(vsubq_s32(bits, vdupq_n_s32(0x3f3504f3)), 23);
+        mantissa = vreinterpretq_f32_s32(vsubq_s32(bits, vshlq_n_s32(exponentBits, 23)));
+        exponent = vcvtq_f32_s32(exponentBits);
+    }
+
+    //the floor and fraction split of decibelsToPower, 'y' clamped to the normal exponents
+    static void splitPowerOfTwo(FloatVector y, FloatVector& fraction, FloatVector& powerOfTwo)
+    {
+        y = vminq_f32(vmaxq_f32(y, expand(-126.f)), expand(127.f));
+
+        //truncation rounds negative values up, a true compare mask is -1 and takes them down to the floor
+        auto whole = vcvtq_s32_f32(y);
+        whole = vaddq_s32(whole, vreinterpretq_s32_u32(vcgtq_f32(vcvtq_f32_s32(whole), y)));
+
+        fraction = vsubq_f32(y, vcvtq_f32_s32(whole));
+        powerOfTwo = vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(whole, vdupq_n_s32(127)), 23));
+    }
+   #endif
+
+   #if PARAMETRICEQ_SSE_SEPARATION || PARAMETRICEQ_NEON_SEPARATION
+    static FloatVector powerToDecibels(FloatVector power, FloatVector floorPower)
+    {
+        FloatVector exponent, mantissa;
+        splitExponent(clampPower(power, floorPower), exponent, mantissa);
+
+        const auto x = subtract(mantissa, expand(1.f));
+        auto log2Mantissa = expand(log2Coefficients[6]);
+        for (int i = 5; i >= 0; --i)
+            log2Mantissa = add(multiply(log2Mantissa, x), expand(log2Coefficients[i]));
+
+        return multiply(expand(3.0102999566398120f), add(exponent, log2Mantissa));
+    }
+
+    //separateBin for bins k..k+3
+    static void separateFourBins(const float* spectrum, int k, int fftSize, float powerScale, float floorPower,
+        FloatVector& left, FloatVector& right)
+    {
+        FloatVector re, im, mirroredRe, mirroredIm;
+        loadBins(spectrum, k, fftSize, re, im, mirroredRe, mirroredIm);
+
+        const auto square = [](FloatVector v) { return multiply(v, v); };
+        const auto leftPower = add(square(add(re, mirroredRe)), square(subtract(im, mirroredIm)));
+        const auto rightPower = add(square(subtract(re, mirroredRe)), square(add(im, mirroredIm)));
+
+        const auto scale = expand(powerScale), floor = expand(floorPower);
+        left = powerToDecibels(multiply(leftPower, scale), floor);
+        right = powerToDecibels(multiply(rightPower, scale), floor);
+    }
+   #endif
+
+    //interleaves windowed L/R into { re, im } pairs. branch free, so the compiler can vectorise it.
+    static void windowAndPack(float* packed, const float* left, const float* right, const float* windowTable, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            packed[2 * i] = left[i] * windowTable[i];
+            packed[2 * i + 1] = right[i] * windowTable[i];
         }
+    }
+
+    //the window is shared with every other generator in the process, the FFT and scratch are our own
+    struct Plan
+    {
+        explicit Plan(int planOrder) :
+            tables(AnalyzerTables::get(planOrder, juce::dsp::WindowingFunction<float>::blackmanHarris)),
+            forwardFFT(planOrder),
+            packedInput((size_t)1 << planOrder),
+            packedSpectrum((size_t)1 << planOrder),
+            packedPreSpectrum((size_t)1 << planOrder)
+        {
+        }
+
+        AnalyzerTables::Ptr tables;
+        //our own, perform() locks its scratch (see AnalyzerTables)
+        juce::dsp::FFT forwardFFT;
+        std::vector<juce::dsp::Complex<float>> packedInput, packedSpectrum, packedPreSpectrum;
+
+        juce::uint32 lastUsed = 0;
+    };
+
+    /**
+     windows two rings (the oldest sample at 'oldestIndex') into the plan's packed input and transforms it.
+     unwraps and windows in the same pass: oldest..end, then start..oldest.
+     */
+    void transform(Plan& plan, const float* leftBuffer, const float* rightBuffer, int oldestIndex,
+        std::vector<juce::dsp::Complex<float>>& spectrum)
+    {
+        const auto fftSize = getFFTSize();
+        const auto* windowTable = plan.tables->windowTable.data();
+
+        auto* packed = reinterpret_cast<float*>(plan.packedInput.data());
+        const auto numOldest = fftSize - oldestIndex;
+        windowAndPack(packed, leftBuffer + oldestIndex, rightBuffer + oldestIndex, windowTable, numOldest);
+        windowAndPack(packed + 2 * numOldest, leftBuffer, rightBuffer, windowTable + numOldest, oldestIndex);
+
+        plan.forwardFFT.perform(plan.packedInput.data(), spectrum.data(), false);
+    }
+
+    FFTOrder order;
+    std::array<std::unique_ptr<Plan>, maxOrder - minOrder + 1> plans;
+    Plan* currentPlan = nullptr;
+
+    TripleBuffer<Frame> fftDataBuffer;
+};
+
+/**
+ which FFT bins land in which pixel column of the analyzer, built once per
+ (fftSize, sampleRate, numBands, width, pixelsPerColumn) instead of mapping every bin on every frame.
+
+ with more than one band, band b runs at sampleRate / 2^b and every column takes its bins
+ from the finest band that still covers it, so the low end gets the long windows.
+ */
+struct SpectrumColumnMap
+{
+    static constexpr int maxBands = 6;
 
-        pathFifo.push(p);
+    //a band is used up to this fraction of its own sample rate, i.e. 70% of its nyquist
+    static constexpr double bandUpperLimit = 0.35;
+
+    struct Column
+    {
+        float x = 0.f;
+        int band = 0;
+        //the bins whose frequency falls inside the column
+        int firstBin = 0;
+        int numBins = 0;
+        //columns without a bin of their own (low frequencies) interpolate between firstBin and firstBin + 1
+        float fraction = 0.f;
+
+        //with smoothing on: the column shows the mean over [smoothingStart, smoothingEnd), in bins
+        bool smoothed = false;
+        float smoothingStart = 0.f;
+        float smoothingEnd = 0.f;
+    };
+
+    /**
+     'smoothing' is N for 1/N-octave smoothing (3, 6, 12, 24), or 0 for none.
+     */
+    void prepare(int fftSize, double sampleRate, int numBands, int width, int pixelsPerColumn, int smoothing);
+
+    bool matches(int fftSize, double sampleRate, int numBands, int width, int pixelsPerColumn, int smoothing) const
+    {
+        return fftSize == mappedFFTSize && sampleRate == mappedSampleRate && numBands == mappedNumBands
+            && width == mappedWidth && pixelsPerColumn == mappedPixelsPerColumn && smoothing == mappedSmoothing;
     }
 
-    int getNumPathsAvailable() const
+    //what a column spanning several bins shows: spectra their loudest bin, the pre/post difference their mean
+    enum class Reduction
     {
-        return pathFifo.getNumAvailableForReading();
+        loudest,
+        mean
+    };
+
+    /**
+     reduces one channel's band frames to one level per column as 'reduction' says,
+     or with smoothing, to the mean over the column's fractional-octave window.
+     a band without a frame yet (nullptr) shows as 'floorLevel'.
+     spectra are smoothed over power and converted back to dB once per column. a difference is a gain,
+     so it's averaged as dB.
+     */
+    void reduce(const std::array<const float*, maxBands>& bandFrames,
+        float floorLevel,
+        float* columnLevels,
+        Reduction reduction = Reduction::loudest);
+
+    const std::vector<Column>& getColumns() const { return columns; }
+    int getPixelsPerColumn() const { return mappedPixelsPerColumn; }
+private:
+    std::vector<Column> columns;
+
+    int mappedFFTSize = 0;
+    double mappedSampleRate = 0.0;
+    int mappedNumBands = 0;
+    int mappedWidth = 0;
+    int mappedPixelsPerColumn = 0;
+    int mappedSmoothing = 0;
+
+    //running sums of the band being reduced, so any window's mean costs two lookups
+    std::vector<double> prefixSums;
+    //the band's levels as power, when it's smoothed in the power domain
+    std::vector<float> binPowers;
+    float getMean(const float* bins, float start, float end) const;
+};
+
+/**
+ rasterises both channels' spectra straight into an image, one anti-aliased
+ polyline per channel, so paint() only has to blit it. no path flattening or stroking.
+ */
+struct SpectrumImageRenderer
+{
+    /**
+     draws one frame into the mailbox's write slot and publishes it.
+     'width' x 'height' is the size of the analysis area, the image is drawn at its top left.
+     'differenceLevels' is the pre/post-EQ difference, nullptr without a pre-EQ tap.
+     */
+    void render(const std::array<const float*, 2>& columnLevels,
+        const float* differenceLevels,
+        const SpectrumColumnMap& columnMap,
+        int width,
+        int height,
+        float negativeInfinity);
+
+    /**
+     makes the newest image available through getImage(). returns false if there is no new image.
+     */
+    bool pullImage() { return imageBuffer.pull(); }
+    const juce::Image& getImage() const { return imageBuffer.getReadBuffer(); }
+private:
+    TripleBuffer<juce::Image> imageBuffer;
+
+    //column centres in y, for the channel being drawn
+    std::vector<float> columnYs;
+
+    //one anti-aliased polyline through the column centres
+    void drawLevels(const juce::Image::BitmapData& bitmap, const std::vector<SpectrumColumnMap::Column>& columns, juce::PixelARGB colour);
+
+    static void drawSpan(const juce::Image::BitmapData& bitmap, int x, float y1, float y2, juce::PixelARGB colour);
+};
+
+
+/**
+ scrolling spectrogram, newest frame at the top. frequency runs along x like the response curve,
+ so every frame becomes one row of pixels, coloured through a lookup table on the analyzer thread.
+ the message thread copies queued rows into a ring image and paint() draws the ring's two halves:
+ nothing is ever scrolled, and a frame costs one row whatever the history length.
+ */
+struct SpectrogramRenderer
+{
+    /**
+     analyzer thread: colours one frame (the louder of both channels) and queues it.
+     'height' is the number of rows of history to keep. if the message thread fell behind, the frame is dropped.
+     */
+    void pushRow(const std::array<const float*, 2>& columnLevels,
+        const SpectrumColumnMap& columnMap,
+        int width,
+        int height,
+        float negativeInfinity);
+
+    /**
+     message thread: moves queued rows into the ring. returns true if any arrived.
+     */
+    bool pullRows();
+
+    //message thread. draws the history with its top left at x, y.
+    void draw(juce::Graphics& g, int x, int y) const;
+
+    /**
+     drops queued rows and clears the history. must not run concurrently with pushRow().
+     */
+    void reset();
+
+    //level -> colour, from negativeInfinity at index 0 up to 0 dB at the end. shared with the history view.
+    static constexpr int tableSize = 256;
+    static const std::array<juce::PixelARGB, tableSize>& getColourTable();
+private:
+
+    struct Row
+    {
+        std::vector<juce::PixelARGB> pixels;
+        int historyLength = 0;
+    };
+
+    //rows only change hands through the fifo, so each is touched by one thread at a time
+    static constexpr int queueSize = 16;
+    std::array<Row, queueSize> rows;
+    juce::AbstractFifo queue { queueSize };
+
+    std::vector<float> loudest;
+
+    //message thread only
+    juce::Image history;
+    int newestRow = 0;
+};
+
+
+/**
+ draws the long-term history as a heat map in the spectrogram's colours: frequency along x,
+ the last 'span' seconds running down from now. every image is read fresh from the pyramid,
+ so it costs O(pixels) whatever the span, and zooming is just a different span.
+ rows nothing was recorded in stay transparent.
+ */
+struct HistoryRenderer
+{
+    //analyzer thread. averages over the span, one row per pixel, published like the spectrum image.
+    void render(const SpectralHistory& spectralHistory, double spanSeconds, double nowSeconds,
+        int width, int height, float negativeInfinity);
+
+    bool pullImage() { return imageBuffer.pull(); }
+    const juce::Image& getImage() const { return imageBuffer.getReadBuffer(); }
+
+    //drops a published image and makes the next needsRender() true
+    void reset()
+    {
+        imageBuffer.pull();
+        renderedWidth = renderedHeight = 0;
     }
 
-    bool getPath(PathType& path)
+    //true if the history or the layout changed since the last render(), or the rows have moved on since
+    bool needsRender(const SpectralHistory& spectralHistory, double spanSeconds, double nowSeconds, int width, int height) const
     {
-        return pathFifo.pull(path);
+        return spectralHistory.getVersion() != renderedVersion || spanSeconds != renderedSpan
+            || width != renderedWidth || height != renderedHeight
+            || getRow(nowSeconds, spanSeconds, height) != renderedRow;
     }
 private:
-    Fifo<PathType> pathFifo;
+    TripleBuffer<juce::Image> imageBuffer;
+    std::vector<float> averages, maxima;
+
+    juce::uint32 renderedVersion = 0;
+    double renderedSpan = 0.0;
+    int renderedWidth = 0, renderedHeight = 0;
+    juce::int64 renderedRow = 0;
+
+    //counts rows since the epoch, so it goes up by one whenever the image should scroll by one
+    static juce::int64 getRow(double nowSeconds, double spanSeconds, int height)
+    {
+        return height > 0 ? (juce::int64)(nowSeconds * height / spanSeconds) : 0;
+    }
 };
 
 
 struct PathProducer
 {
-    PathProducer(SingleChannelSampleFifo<ParametricEQAudioProcessor::BlockType>& scsf) :
-        leftChannelFifo(&scsf)
+    using Fifo = SingleChannelSampleFifo<ParametricEQAudioProcessor::BlockType>;
+
+    static constexpr int maxBands = SpectrumColumnMap::maxBands;
+
+    /**
+     the pre-EQ signals are the ones after them, Channel + preEQOffset.
+     with the pre-EQ tap off only the first two are analyzed.
+     */
+    static constexpr int maxSignals = 4;
+    static constexpr int preEQOffset = 2;
+    using Signals = std::array<const float*, maxSignals>;
+
+    //the history view only draws 'history', the processor keeps it going whether there's an editor or not
+    PathProducer(Fifo& leftFifo, Fifo& rightFifo, Fifo& leftPreEQFifo, Fifo& rightPreEQFifo,
+        const ParametricEQAudioProcessor::PreEQTapPosition& tapPosition, const QualityGovernor& governor,
+        const SpectralHistory& history) :
+        preEQTapPosition(&tapPosition),
+        qualityGovernor(&governor),
+        spectralHistory(history)
     {
-        leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
-        monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+        channelFifos[Channel::Left] = &leftFifo;
+        channelFifos[Channel::Right] = &rightFifo;
+        channelFifos[Channel::Left + preEQOffset] = &leftPreEQFifo;
+        channelFifos[Channel::Right + preEQOffset] = &rightPreEQFifo;
+
+        unwrapped.resize(FFTDataGenerator<std::vector<float>>::maxFFTSize);
+
+        for (auto& stage : inputScratch)
+            for (auto& buffer : stage)
+                buffer.resize(maxChunkSize / 2 + 1);
+
+        updateBands();
     }
     void process(juce::Rectangle<float> fftBounds, double sampleRate);
-    juce::Path getPath() { return leftChannelFFTPath; }
+
+    /**
+     sets the analyzer's resolution. safe to call from any thread, the switch
+     happens on the next process() and keeps the audio already in the window.
+     */
+    void setFFTOrder(FFTOrder newOrder) { fftOrder.store(newOrder); }
+
+    /**
+     number of octave bands, 1 for a plain single FFT. safe to call from any thread.
+     band b is decimated by 2^b and analyzed with the same FFT size, so every extra band
+     halves the bin width below its crossover for at most half the cost of the band above.
+     */
+    void setNumBands(int newNumBands) { numBands.store(juce::jlimit(1, maxBands, newNumBands)); }
+
+    /**
+     also analyzes the signal before the EQ and shows the post - pre difference, i.e. what the EQ
+     is actually doing. costs one more FFT per band. safe to call from any thread.
+     takes effect once the processor feeds the pre-EQ fifos, which it does from the same setting.
+     */
+    void setPreEQTap(bool shouldTapPreEQ) { preEQTap.store(shouldTapPreEQ); }
+
+    //spectrum lines, spectrogram or long-term history. safe to call from any thread.
+    void setView(AnalyzerView newView) { view.store(newView); }
+    AnalyzerView getView() const { return view.load(); }
+
+    /**
+     how far back the history view reaches, up to SpectralHistory::getMaxSpanSeconds().
+     the history itself is kept whatever the view, as long as the analyzer runs. safe to call from any thread.
+     */
+    void setHistorySpan(double seconds) { historySpan.store(juce::jlimit(1.0, SpectralHistory::getMaxSpanSeconds(), seconds)); }
+
+    //N for 1/N-octave smoothing, 0 for none. safe to call from any thread.
+    void setSmoothing(int octaveFraction) { smoothing.store(octaveFraction); }
+
+    /**
+     averaging and hold settings, safe to call from any thread.
+     'averagingTime' is the time constant of the exponential average,
+     'peakDecay' how fast peak-hold falls back, in dB per second.
+     */
+    void setAnalyzerMode(AnalyzerMode newMode) { analyzerMode.store(newMode); }
+    void setAveragingTime(float seconds) { averagingTime.store(juce::jmax(0.001f, seconds)); }
+    void setPeakDecay(float decibelsPerSecond) { peakDecay.store(juce::jmax(0.f, decibelsPerSecond)); }
+
+    /**
+     how much consecutive FFT frames overlap, e.g. 0.5 or 0.75.
+     the analyzer runs exactly one FFT per (1 - overlap) * fftSize samples, whatever the host's block size
+     (times the QualityGovernor's hop multiplier when it has cut the analyzer back).
+     */
+    void setOverlap(float newOverlap)
+    {
+        overlap = juce::jlimit(0.f, 0.9375f, newOverlap);
+
+        for (int b = 0; b < activeBands; ++b)
+            bands[b]->samplesUntilNextHop = juce::jmin(bands[b]->samplesUntilNextHop, getHopSize());
+    }
+
+    /**
+     throws away everything queued or rendered so far, so the analyzer starts
+     from fresh audio after it was detached or switched off.
+     must not run concurrently with process().
+     */
+    void reset();
+
+    /**
+     process() runs on the analyzer thread, these on the message thread.
+     pullImage() returns true if a new spectrum image, history image or spectrogram row came in since the last call.
+     getImage() is the spectrum or history image, whichever view is on.
+     */
+    bool pullImage();
+    const juce::Image& getImage() const;
+    const SpectrogramRenderer& getSpectrogram() const { return spectrogramRenderer; }
+
+    //every frame of every band goes to the recorder while it's recording, as it's produced
+    SpectrumRecorder& getRecorder() { return recorder; }
 private:
-    SingleChannelSampleFifo<ParametricEQAudioProcessor::BlockType>* leftChannelFifo;
+    std::array<Fifo*, maxSignals> channelFifos;
+    const ParametricEQAudioProcessor::PreEQTapPosition* preEQTapPosition;
+    const QualityGovernor* qualityGovernor;
+
+    //the order asked for, the governor may run a smaller one
+    std::atomic<FFTOrder> fftOrder { FFTOrder::order2048 };
+    std::atomic<int> numBands { 1 };
+    std::atomic<int> smoothing { 0 };
+    std::atomic<AnalyzerView> view { spectrumView };
+    std::atomic<double> historySpan { 600.0 };
+    std::atomic<bool> preEQTap { false };
+
+    //2, or maxSignals with the pre-EQ tap
+    int numSignals = 2;
+    void updatePreEQTap();
+
+    std::atomic<AnalyzerMode> analyzerMode { AnalyzerMode::raw };
+    std::atomic<float> averagingTime { 0.3f };
+    std::atomic<float> peakDecay { 12.f };
+
+    void updateOutputStage(double sampleRate);
+
+    void updateOrderForQuality();
+    void updateBands();
+
+    float overlap = 0.5f;
+    //under CPU pressure the governor stretches the hop, possibly past the window, rather than gaps being cut into the audio
+    int getHopSize() const
+    {
+        return juce::jmax(1, juce::roundToInt(getFFTSize() * (1.f - overlap))) * qualityGovernor->getAnalyzerHopMultiplier();
+    }
+    int getFFTSize() const { return bands[0]->fftDataGenerator.getFFTSize(); }
+
+    //one octave band: its own window rings and FFT, plus the decimators that feed the next band
+    struct Band
+    {
+        Band();
+
+        //the last fftSize samples of each channel as rings; 'writeIndex' is both the next write and the oldest sample
+        std::array<std::vector<float>, maxSignals> windowBuffers;
+        int writeIndex = 0;
+        int samplesUntilNextHop = 0;
+
+        //both channels go through one complex FFT
+        FFTDataGenerator<std::vector<float>> fftDataGenerator;
+        bool hasFrame = false;
+
+        std::array<HalfBandDecimator, maxSignals> decimators;
+        std::array<std::vector<float>, maxSignals> decimated;
+    };
+
+    //samples are pushed through the bands in chunks of at most this, which bounds the decimator scratch
+    static constexpr int maxChunkSize = 512;
+
+    /**
+     the display stops at 20 kHz, so at high sample rates the input is halved until it's
+     back at 44.1/48 kHz before it reaches the first band. 96k -> 48k, 192k -> 96k -> 48k.
+     */
+    static constexpr int maxInputStages = 3;
+    static int getNumInputStages(double sampleRate);
+
+    int numInputStages = 0;
+    std::array<std::array<HalfBandDecimator, maxSignals>, maxInputStages> inputDecimators;
+    std::array<std::array<std::vector<float>, maxSignals>, maxInputStages> inputScratch;
+
+    void updateInputStages(double sampleRate);
+    void pushInput(Signals signals, int numSamples);
+
+    //clears all windows and decimators, e.g. when the rate or the signals feeding them change
+    void restartBands();
+
+    //drains go by the fifo with the least in it, so all of them stay in step
+    int getNumSamplesInAllFifos() const;
+    void drainFifos();
+
+    /**
+     skips the post-EQ audio from before the pre-EQ tap came on and the pre-EQ leftovers from the last
+     time it was on, until both read positions are the same distance past where the tap started.
+     returns false while the fifos can't be lined up yet.
+     */
+    bool alignPreEQFifos();
+
+    //holds every fifo's resize lock, see SingleChannelSampleFifo::getResizeLock()
+    struct ScopedFifoLock
+    {
+        explicit ScopedFifoLock(const std::array<Fifo*, maxSignals>& fifosToLock) : fifos(fifosToLock)
+        {
+            for (auto* fifo : fifos)
+                fifo->getResizeLock().enter();
+        }
+
+        ~ScopedFifoLock()
+        {
+            for (auto* fifo : fifos)
+                fifo->getResizeLock().exit();
+        }
+
+        const std::array<Fifo*, maxSignals>& fifos;
+    };
+
+    //bands are created the first time they're used and kept afterwards
+    std::array<std::unique_ptr<Band>, maxBands> bands;
+    int activeBands = 0;
+
+    std::vector<float> unwrapped;
 
-    juce::AudioBuffer<float> monoBuffer;
+    void prepareWindow(Band& band);
+    void resizeWindow(Band& band, int oldSize, int newSize);
+    void pushSamples(int bandIndex, const Signals& signals, int numSamples);
 
-    FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
+    SpectrumColumnMap columnMap;
+    std::array<std::vector<float>, 2> columnLevels;
+    std::vector<float> differenceLevels;
+    SpectrumImageRenderer spectrumRenderer;
+    SpectrogramRenderer spectrogramRenderer;
 
-    AnalyzerPathGenerator<juce::Path> pathProducer;
+    const SpectralHistory& spectralHistory;
+    HistoryRenderer historyRenderer;
 
-    juce::Path leftChannelFFTPath;
+    void renderHistory(juce::Rectangle<float> fftBounds);
+
+    bool hasImage = false;
+    bool hasHistoryImage = false;
+    juce::Image emptyImage;
+
+    SpectrumRecorder recorder;
+    //the first band's rate, what the recorder is told the frames were taken at
+    double analysisSampleRate = 0.0;
+};
+
+
+/**
+ runs the PathProducer on the process-wide analyzer workers, so windowing, FFT and spectrum
+ rendering don't compete with painting or the host's UI on the message thread, and many open
+ editors share a few threads and one CPU budget. paint() only draws the finished image.
+ */
+struct AnalyzerTask : AnalyzerScheduler::Client
+{
+    AnalyzerTask(ParametricEQAudioProcessor&, PathProducer&);
+    ~AnalyzerTask() override;
+
+    void setAnalysisBounds(juce::Rectangle<float> bounds);
+    void setEnabled(bool shouldBeEnabled) { enabled.store(shouldBeEnabled); }
+
+    /**
+     takes the task off the workers while the producer is reset. message thread only.
+     */
+    void resetProducer();
+
+    void runAnalysis() override;
+private:
+    ParametricEQAudioProcessor& audioProcessor;
+    PathProducer& pathProducer;
+
+
+    std::atomic<bool> enabled { true };
+
+    juce::SpinLock boundsLock;
+    juce::Rectangle<float> analysisBounds;
+
+    juce::SharedResourcePointer<AnalyzerScheduler> scheduler;
+};
+
+/**
+ keeps the processor's SpectralHistory going for as long as the plugin exists, editor or not.
+ runs on the same workers as the editors' analyzers, but reads its own always-fed fifos through a
+ fixed 8192 point window with no output stage, and reduces every frame to the history's 1/6 octave bands.
+ the processor owns it.
+ */
+struct HistoryAnalyzer : AnalyzerScheduler::Client
+{
+    explicit HistoryAnalyzer(ParametricEQAudioProcessor&);
+    ~HistoryAnalyzer() override;
+
+    void runAnalysis() override;
+private:
+    ParametricEQAudioProcessor& audioProcessor;
+
+    FFTDataGenerator<std::vector<float>> generator;
+    std::array<std::vector<float>, 2> windowBuffers;
+    int writeIndex = 0;
+    int samplesUntilNextHop = 0;
+
+    //a few frames per 0.1 s history slot is plenty
+    int getHopSize() const { return generator.getFFTSize() / 4; }
+
+    //fixed 1/6 octave bands, so the history doesn't depend on the window size or resolution
+    SpectrumColumnMap bandMap;
+    std::array<std::vector<float>, 2> bandLevels;
+    std::array<float, SpectralHistory::numBands> historyLevels;
+
+    void addToHistory(const float* left, const float* right);
+
+    juce::SharedResourcePointer<AnalyzerScheduler> scheduler;
 };
 
 
@@ -242,6 +1212,20 @@ private:
 };
 
 
+/**
+ peak / RMS per channel, the correlation and the loudness, as text.
+ opaque and its own component, so refreshing the numbers only repaints this strip
+ and not the response curve underneath it.
+ */
+struct MeterComponent : juce::Component
+{
+    explicit MeterComponent(ParametricEQAudioProcessor& p);
+
+    void paint(juce::Graphics& g) override;
+private:
+    ParametricEQAudioProcessor& audioProcessor;
+};
+
 struct ResponseCurveComponent : public juce::Component,
     juce::AudioProcessorParameter::Listener,
     juce::Timer
@@ -259,9 +1243,17 @@ struct ResponseCurveComponent : public juce::Component,
 
     void resized() override;
 
+    //right click: start or stop recording the analyzer to a file
+    void mouseDown(const juce::MouseEvent& e) override;
+
     void toggleAnalysisEnablement(bool enabled)
     {
+        //the processor stopped feeding while it was off, don't show what was left over from back then
+        if (enabled && !shouldShowFFTAnalysis)
+            analyzerTask.resetProducer();
+
         shouldShowFFTAnalysis = enabled;
+        analyzerTask.setEnabled(enabled);
     }
 
 private:
@@ -294,7 +1286,18 @@ private:
 
     juce::Rectangle<int> getAnalysisArea();
 
-    PathProducer leftPathProducer, rightPathProducer;
+    //the analysis area's top left corner
+    juce::Rectangle<int> getMeterArea();
+    MeterComponent meter;
+    int meterRefreshCounter = 0;
+
+    PathProducer pathProducer;
+
+    std::unique_ptr<juce::FileChooser> recordingChooser;
+    void chooseRecordingFile(bool quantiseToFloat16);
+
+    //declared after the producer so it's off the workers before the producer goes away
+    AnalyzerTask analyzerTask;
 };
 
 
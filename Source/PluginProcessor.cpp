@@ -22,6 +22,8 @@ ParametricEQAudioProcessor::ParametricEQAudioProcessor()
       )
 #endif
 {
+    analyzerEnabled = apvts.getRawParameterValue("Analyzer Enabled");
+    historyAnalyzer = std::make_unique<HistoryAnalyzer>(*this);
 }
 
 ParametricEQAudioProcessor::~ParametricEQAudioProcessor()
@@ -103,8 +105,25 @@ void ParametricEQAudioProcessor::prepareToPlay(double sampleRate, int samplesPer
 
     updateFilters();
 
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    //enough for the editor to miss a few frames without the analyzer losing samples
+    auto analyzerRingSize = juce::jmax(samplesPerBlock * 4, juce::roundToInt(sampleRate * 0.2));
+    leftChannelFifo.prepare(analyzerRingSize);
+    rightChannelFifo.prepare(analyzerRingSize);
+    leftPreEQFifo.prepare(analyzerRingSize);
+    rightPreEQFifo.prepare(analyzerRingSize);
+
+    //the history's analyzer shares the workers with every open editor, so it may have to wait a few ticks
+    auto historyRingSize = juce::jmax(samplesPerBlock * 4, juce::roundToInt(sampleRate * 0.5));
+    leftHistoryFifo.prepare(historyRingSize);
+    rightHistoryFifo.prepare(historyRingSize);
+
+    //the fifos start over, so where the pre-EQ tap starts is taken again on the next block
+    preEQTapped = false;
+    preEQTapPosition.offset.store(-1);
+
+    qualityGovernor.prepare(sampleRate);
+    outputMeter.prepare(sampleRate);
+    loudnessMeter.prepare(sampleRate, samplesPerBlock);
 
     osc.initialise([](float x) { return std::sin(x); });
 
@@ -148,6 +167,8 @@ bool ParametricEQAudioProcessor::isBusesLayoutSupported(const BusesLayout &layou
 void ParametricEQAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -162,7 +183,34 @@ void ParametricEQAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
     
     updateFilters();
 
+    //decided once per block, so the pre and post-EQ fifos always get the same blocks.
+    //every block goes in, under CPU pressure the analyzer hops further instead, so its windows stay contiguous
+    const auto feedAnalyzer = shouldFeedAnalyzer();
+
+    //the pre-EQ tap has to be taken before the chains process the buffer in place,
+    //and only while it's shown. where it starts is published before the first pre-EQ sample goes in.
+    const auto tapPreEQ = analyzerSettings.isOn(AnalyzerSettings::preEQ);
+    if (tapPreEQ != preEQTapped)
+    {
+        preEQTapped = tapPreEQ;
+
+        if (tapPreEQ)
+        {
+            const auto firstSample = leftPreEQFifo.getNumSamplesWritten();
+            preEQTapPosition.firstSample.store(firstSample);
+            preEQTapPosition.offset.store(leftChannelFifo.getNumSamplesWritten() - firstSample);
+        }
+        else
+        {
+            preEQTapPosition.offset.store(-1);
+        }
+    }
 
+    if (feedAnalyzer && tapPreEQ)
+    {
+        leftPreEQFifo.update(buffer);
+        rightPreEQFifo.update(buffer);
+    }
 
     juce::dsp::AudioBlock<float> block(buffer);
 
@@ -175,8 +223,27 @@ void ParametricEQAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
     leftChain.process(leftContext);
     rightChain.process(rightContext);
 
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+    //while the filtered block is still in cache
+    outputMeter.process(buffer.getReadPointer(0), buffer.getReadPointer(1), buffer.getNumSamples());
+    loudnessMeter.process(buffer, analyzerSettings.isOn(AnalyzerSettings::truePeak));
+
+    if (feedAnalyzer)
+    {
+        leftChannelFifo.update(buffer);
+        rightChannelFifo.update(buffer);
+    }
+
+    leftHistoryFifo.update(buffer);
+    rightHistoryFifo.update(buffer);
+
+    //offline renders have no realtime budget to protect
+    if (!isNonRealtime())
+        qualityGovernor.blockProcessed(juce::Time::getHighResolutionTicks() - startTicks, buffer.getNumSamples());
+}
+
+bool ParametricEQAudioProcessor::shouldFeedAnalyzer() const
+{
+    return analyzerConsumers.load() > 0 && analyzerEnabled->load() > 0.5f;
 }
 
 //==============================================================================
@@ -212,6 +279,7 @@ void ParametricEQAudioProcessor::setStateInformation(const void *data, int sizeI
     if (tree.isValid())
     {
         apvts.replaceState(tree);
+        analyzerSettings.loadFromState();
         updateFilters();
     }
 }
@@ -237,12 +305,14 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState &apvts)
   
 }
 
+Coefficients makeCoefficients(const eqcore::BiquadCoefficients& c)
+{
+    return *new juce::dsp::IIR::Coefficients<float>(c.b0, c.b1, c.b2, 1.f, c.a1, c.a2);
+}
+
 Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
 {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-        chainSettings.peakFreq,
-        chainSettings.peakQuality,
-        juce::Decibels::decibelsToGain(chainSettings.peakGain));
+    return makeCoefficients(eqcore::designPeakFilter(chainSettings, sampleRate));
 }
 
 
@@ -364,6 +434,8 @@ ParametricEQAudioProcessor::createParameterLayout()
     layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypassed", "HighCut Bypassed", false));
     layout.add(std::make_unique<juce::AudioParameterBool>("Analyzer Enabled", "Analyzer Enabled", true));
 
+    //the analyzer's and the meter's display options live in AnalyzerSettings, they aren't host parameters
+
     return layout;
 }
 
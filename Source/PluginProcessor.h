@@ -9,6 +9,12 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "EQCore/EQCore.h"
+#include "QualityGovernor.h"
+#include "OutputMeter.h"
+#include "LoudnessMeter.h"
+#include "AnalyzerSettings.h"
+#include "SpectralHistory.h"
 
 #include <array>
 template<typename T>
@@ -74,6 +80,66 @@ private:
     juce::AbstractFifo fifo{ Capacity };
 };
 
+/**
+ lock-free mailbox for data where only the newest value matters.
+ the writer fills its own slot and publishes it by swapping slot indices with
+ the reader, so payloads are never copied and nothing is allocated after prepare().
+ one writer thread and one reader thread.
+ */
+template<typename T>
+struct TripleBuffer
+{
+    /**
+     runs 'initialise' on all three slots, e.g. to preallocate them.
+     not thread safe, call it while neither side is running.
+     */
+    template<typename Initialiser>
+    void prepare(Initialiser&& initialise)
+    {
+        for (auto& buffer : buffers)
+            initialise(buffer);
+
+        writeIndex = 0;
+        readIndex = 1;
+        middle.store(2);
+    }
+    //==============================================================================
+    T& getWriteBuffer() { return buffers[writeIndex]; }
+
+    /**
+     hands the write slot to the reader. an older value the reader never picked up is recycled.
+     */
+    void publish()
+    {
+        auto previous = middle.exchange(writeIndex | newDataFlag, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+    //==============================================================================
+    /**
+     swaps in the newest published value, if there is one. returns false if nothing new arrived.
+     */
+    bool pull()
+    {
+        if ((middle.load(std::memory_order_acquire) & newDataFlag) == 0)
+            return false;
+
+        auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    //stays valid until the next pull()
+    const T& getReadBuffer() const { return buffers[readIndex]; }
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newDataFlag = 4;
+
+    std::array<T, 3> buffers;
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> middle { 2 };
+};
+
 enum Channel
 {
     Right, //effectively 0
@@ -81,6 +147,95 @@ enum Channel
 };
 
 
+/**
+ wait-free single producer / single consumer ring of raw floats.
+ the producer writes whole blocks with at most two copies, the consumer reads
+ spans straight out of the ring without copying them.
+ */
+struct SampleRing
+{
+    struct Spans
+    {
+        const float* data1 = nullptr;
+        int size1 = 0;
+        const float* data2 = nullptr;
+        int size2 = 0;
+
+        int getTotalSize() const { return size1 + size2; }
+    };
+
+    //allocates, so only call this while neither side is running. SingleChannelSampleFifo::prepare() makes sure of that for the reader
+    void prepare(int numSamples)
+    {
+        //AbstractFifo keeps one slot free to tell 'full' from 'empty'
+        buffer.assign((size_t)numSamples + 1, 0.f);
+        fifo.setTotalSize(numSamples + 1);
+        fifo.reset();
+        numOverflowedSamples.store(0);
+        numWritten.store(0);
+        numRead = 0;
+    }
+
+    /**
+     producer side. whatever doesn't fit is dropped and counted as overflow.
+     */
+    int write(const float* data, int numSamples)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+        if (size1 > 0)
+            juce::FloatVectorOperations::copy(buffer.data() + start1, data, size1);
+        if (size2 > 0)
+            juce::FloatVectorOperations::copy(buffer.data() + start2, data + size1, size2);
+
+        const auto written = size1 + size2;
+        fifo.finishedWrite(written);
+        numWritten.store(numWritten.load(std::memory_order_relaxed) + written, std::memory_order_release);
+
+        if (written < numSamples)
+            numOverflowedSamples.fetch_add(numSamples - written);
+
+        return written;
+    }
+
+    /**
+     consumer side. the spans stay valid until finishedRead() is called.
+     */
+    Spans read(int maxSamples) const
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxSamples, start1, size1, start2, size2);
+
+        Spans spans;
+        spans.data1 = buffer.data() + start1;
+        spans.size1 = size1;
+        spans.data2 = buffer.data() + start2;
+        spans.size2 = size2;
+        return spans;
+    }
+
+    void finishedRead(int numSamples)
+    {
+        fifo.finishedRead(numSamples);
+        numRead += numSamples;
+    }
+
+    int getNumReady() const { return fifo.getNumReady(); }
+    int getCapacity() const { return fifo.getTotalSize() - 1; }
+    juce::int64 getNumOverflowedSamples() const { return numOverflowedSamples.load(); }
+
+    //positions since prepare(), dropped samples not counted. numRead is the consumer's own.
+    juce::int64 getNumWritten() const { return numWritten.load(std::memory_order_acquire); }
+    juce::int64 getNumRead() const { return numRead; }
+private:
+    std::vector<float> buffer;
+    juce::AbstractFifo fifo{ 1 };
+    std::atomic<juce::int64> numOverflowedSamples{ 0 };
+    std::atomic<juce::int64> numWritten{ 0 };
+    juce::int64 numRead = 0;
+};
+
 template<typename BlockType>
 struct SingleChannelSampleFifo
 {
@@ -93,76 +248,49 @@ struct SingleChannelSampleFifo
     {
         jassert(prepared.get());
         jassert(buffer.getNumChannels() > channelToUse);
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
 
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
-        {
-            pushNextSampleIntoFifo(channelPtr[i]);
-        }
+        ring.write(buffer.getReadPointer(channelToUse), buffer.getNumSamples());
     }
 
-    void prepare(int bufferSize)
+    /**
+     'ringSize' is how many samples can wait for the reader before new ones get dropped.
+     hosts call prepareToPlay while the editor's analyzer keeps running, so this waits for
+     the reader to let go of its spans (see getResizeLock()) before the ring is reallocated.
+     the audio thread is never running at the same time, so it doesn't take the lock.
+     */
+    void prepare(int ringSize)
     {
+        const juce::ScopedLock lock(resizeLock);
+
         prepared.set(false);
-        size.set(bufferSize);
-
-        bufferToFill.setSize(1,             //channel
-            bufferSize,    //num samples
-            false,         //keepExistingContent
-            true,          //clear extra space
-            true);         //avoid reallocating
-        audioBufferFifo.prepare(1, bufferSize);
-        fifoIndex = 0;
+        size.set(ringSize);
+
+        ring.prepare(ringSize);
+
         prepared.set(true);
     }
+
+    /**
+     the reader holds this from taking spans with readSamples() until it's done with them.
+     it's only ever contended while prepare() runs.
+     */
+    const juce::CriticalSection& getResizeLock() const { return resizeLock; }
     //==============================================================================
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
+    int getNumSamplesAvailable() const { return ring.getNumReady(); }
     bool isPrepared() const { return prepared.get(); }
     int getSize() const { return size.get(); }
+    juce::int64 getNumOverflowedSamples() const { return ring.getNumOverflowedSamples(); }
+    juce::int64 getNumSamplesWritten() const { return ring.getNumWritten(); }
+    juce::int64 getNumSamplesRead() const { return ring.getNumRead(); }
     //==============================================================================
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
+    SampleRing::Spans readSamples(int maxSamples) const { return ring.read(maxSamples); }
+    void finishedReading(int numSamples) { ring.finishedRead(numSamples); }
 private:
     Channel channelToUse;
-    int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
-    BlockType bufferToFill;
+    SampleRing ring;
+    juce::CriticalSection resizeLock;
     juce::Atomic<bool> prepared = false;
     juce::Atomic<int> size = 0;
-
-    void pushNextSampleIntoFifo(float sample)
-    {
-        if (fifoIndex == bufferToFill.getNumSamples())
-        {
-            auto ok = audioBufferFifo.push(bufferToFill);
-
-            juce::ignoreUnused(ok);
-
-            fifoIndex = 0;
-        }
-
-        bufferToFill.setSample(0, fifoIndex, sample);
-        ++fifoIndex;
-    }
-};
-
-
-enum Slope {
-  Slope_12,
-  Slope_24,
-  Slope_36,
-  Slope_48
-}; 
-
-struct ChainSettings
-{
-    float peakFreq { 0 }, peakGain{ 0 }, peakQuality { 1.f };
-    float lowCutFreq { 0 }, highCutFreq { 0 };
-    
-    Slope lowCutSlope{ Slope::Slope_12 };
-    Slope highCutSlope { Slope::Slope_12 };
-
-    bool lowCutBypassed{ false }, peakBypassed{ false }, highCutBypassed{ false };
-
 };
 
 
@@ -181,8 +309,12 @@ enum ChainPositions
 };
 
 using Coefficients = Filter::CoefficientsPtr;
+using CutCoefficientsArray = juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>>;
 void updateCoefficients(Coefficients& old, const Coefficients& replacements);
 
+//the filters are designed by the JUCE-free core (EQCore), these wrap the results for juce::dsp
+Coefficients makeCoefficients(const eqcore::BiquadCoefficients& coefficients);
+
 Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
 
 
@@ -223,20 +355,31 @@ void updateCutFilter(ChainType& chain,
     }
     }
 }
+inline CutCoefficientsArray makeCutFilter(const eqcore::CutCoefficients& sections, int numSections)
+{
+    CutCoefficientsArray coefficients;
+    for (int i = 0; i < numSections; ++i)
+        coefficients.add(makeCoefficients(sections[i]));
+
+    return coefficients;
+}
+
 inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate )
 {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
-                                                                                       sampleRate,
-                                                                                       2 * (chainSettings.lowCutSlope + 1));
+    eqcore::CutCoefficients sections;
+    auto numSections = eqcore::designLowCutFilter(chainSettings, sampleRate, sections);
+    return makeCutFilter(sections, numSections);
 }
 
 inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate )
 {
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
-                                                                                      sampleRate,
-                                                                                      2 * (chainSettings.highCutSlope + 1));
+    eqcore::CutCoefficients sections;
+    auto numSections = eqcore::designHighCutFilter(chainSettings, sampleRate, sections);
+    return makeCutFilter(sections, numSections);
 }
 //==============================================================================
+struct HistoryAnalyzer;
+
 /**
  */
 class ParametricEQAudioProcessor : public juce::AudioProcessor
@@ -283,13 +426,58 @@ public:
   juce::AudioProcessorValueTreeState apvts{
       *this, nullptr, "Parameters", createParameterLayout()};
 
+  //saved in apvts.state, so it has to come after it
+  AnalyzerSettings analyzerSettings { apvts.state };
+
   using BlockType = juce::AudioBuffer<float>;
   SingleChannelSampleFifo<BlockType> leftChannelFifo{ Channel::Left };
   SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::Right };
+  //the same channels before the EQ, only fed while the "Analyzer Pre-EQ" setting is on
+  SingleChannelSampleFifo<BlockType> leftPreEQFifo{ Channel::Left };
+  SingleChannelSampleFifo<BlockType> rightPreEQFifo{ Channel::Right };
+
+  /**
+   where the pre-EQ tap last came on, written by the audio thread only. the reader lines the
+   fifos up with it, see PathProducer::alignPreEQFifos().
+   */
+  struct PreEQTapPosition
+  {
+      //the pre-EQ fifos' write position the tap started at
+      std::atomic<juce::int64> firstSample { 0 };
+      //how far the post-EQ fifos were ahead of that, or -1 while the tap is off. stored after firstSample,
+      //so the same offset before and after reading firstSample means the two belong together.
+      std::atomic<juce::int64> offset { -1 };
+  };
+
+  const PreEQTapPosition& getPreEQTapPosition() const { return preEQTapPosition; }
+
+  //fed on every block, editor or not, so the long-term history keeps going while no editor is open
+  SingleChannelSampleFifo<BlockType> leftHistoryFifo{ Channel::Left };
+  SingleChannelSampleFifo<BlockType> rightHistoryFifo{ Channel::Right };
+  //written by the HistoryAnalyzer, the editor only draws it
+  SpectralHistory spectralHistory;
+
+  QualityGovernor qualityGovernor;
+  OutputMeter outputMeter;
+  LoudnessMeter loudnessMeter;
+
+  //every component that reads the analyzer fifos registers here; with none attached the feed is skipped
+  void addAnalyzerConsumer() { analyzerConsumers.fetch_add(1); }
+  void removeAnalyzerConsumer() { analyzerConsumers.fetch_sub(1); }
+  bool shouldFeedAnalyzer() const;
 
 private:
   MonoChain leftChain, rightChain;
 
+  std::atomic<int> analyzerConsumers { 0 };
+  std::atomic<float>* analyzerEnabled = nullptr;
+
+  PreEQTapPosition preEQTapPosition;
+  bool preEQTapped = false;
+
+  //declared last, so it's off the analyzer workers before the fifos and the history go away
+  std::unique_ptr<HistoryAnalyzer> historyAnalyzer;
+
   void updatePeakFilter(const ChainSettings& chainSettings);
   void updateLowCutFilters(const ChainSettings& chainSettings);
   void updateHighCutFilters(const ChainSettings& chainSettings);
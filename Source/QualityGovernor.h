@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.h
+
+    Measures processBlock against the block's realtime budget and steps the
+    analyzer's non-essential work down when the budget gets tight.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct QualityGovernor
+{
+    enum Level
+    {
+        Full,
+        Reduced,
+        Minimal
+    };
+
+    //fraction of the block's duration processBlock may use before the analyzer gets cut back
+    static constexpr double stepDownLoad = 0.25;
+    //load has to stay below this for 'stepUpHoldSeconds' before quality goes back up
+    static constexpr double stepUpLoad = 0.10;
+    static constexpr double stepUpHoldSeconds = 2.0;
+    //minimum time between two steps down, so a single spike doesn't go straight to Minimal
+    static constexpr double stepDownHoldSeconds = 0.25;
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        ticksPerSecond = (double)juce::Time::getHighResolutionTicksPerSecond();
+        reset();
+    }
+
+    void reset()
+    {
+        smoothedLoad = 0.0;
+        secondsInHeadroom = 0.0;
+        secondsSinceStepDown = stepDownHoldSeconds;
+        load.store(0.f);
+        level.store(Full);
+    }
+
+    /**
+     called from the end of processBlock with the time the block took.
+     */
+    void blockProcessed(juce::int64 elapsedTicks, int numSamples)
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return;
+
+        const auto budget = numSamples / sampleRate;
+        const auto blockLoad = (elapsedTicks / ticksPerSecond) / budget;
+
+        //overloads are followed within ~50ms, headroom is only trusted over ~500ms
+        const auto timeConstant = blockLoad > smoothedLoad ? 0.05 : 0.5;
+        smoothedLoad += (1.0 - std::exp(-budget / timeConstant)) * (blockLoad - smoothedLoad);
+        load.store((float)smoothedLoad);
+
+        secondsSinceStepDown += budget;
+        auto current = level.load();
+
+        if (smoothedLoad > stepDownLoad)
+        {
+            secondsInHeadroom = 0.0;
+
+            if (current < Minimal && secondsSinceStepDown >= stepDownHoldSeconds)
+            {
+                level.store(current + 1);
+                secondsSinceStepDown = 0.0;
+            }
+        }
+        else if (smoothedLoad < stepUpLoad)
+        {
+            secondsInHeadroom += budget;
+
+            if (current > Full && secondsInHeadroom >= stepUpHoldSeconds)
+            {
+                level.store(current - 1);
+                secondsInHeadroom = 0.0;
+            }
+        }
+        else
+        {
+            secondsInHeadroom = 0.0;
+        }
+    }
+
+    Level getLevel() const { return static_cast<Level>(level.load()); }
+    float getLoad() const { return load.load(); }
+
+    //the analyzer's hop is stretched N times, so it runs N times fewer FFTs on the same contiguous audio
+    int getAnalyzerHopMultiplier() const { return 1 << level.load(); }
+    //pixels per analyzer path column, each column gets one vertex
+    int getPathResolution() const { return 1 << level.load(); }
+    //how many times the analyzer's FFT size is halved
+    int getFFTOrderReduction() const { return level.load(); }
+private:
+    double sampleRate = 0.0;
+    double ticksPerSecond = 1.0;
+
+    double smoothedLoad = 0.0;
+    double secondsInHeadroom = 0.0;
+    double secondsSinceStepDown = 0.0;
+
+    std::atomic<float> load { 0.f };
+    std::atomic<int> level { Full };
+};
@@ -0,0 +1,221 @@
+/*
+  ==============================================================================
+
+    SpectralHistory.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectralHistory.h"
+
+namespace
+{
+    struct LevelLayout
+    {
+        double slotSeconds;
+        int capacity;
+        int childrenPerSlot;
+    };
+
+    //each level's slot is a whole number of the level below's
+    constexpr std::array<LevelLayout, SpectralHistory::numLevels> levelLayouts
+    { {
+        { 0.1, 600, 0 },
+        { 1.0, 900, 10 },
+        { 10.0, 540, 10 },
+        { 60.0, 1440, 6 },
+    } };
+}
+
+SpectralHistory::SpectralHistory()
+{
+    for (int i = 0; i < numLevels; ++i)
+    {
+        auto& level = levels[i];
+        level.slotSeconds = levelLayouts[i].slotSeconds;
+        level.capacity = levelLayouts[i].capacity;
+        level.childrenPerSlot = levelLayouts[i].childrenPerSlot;
+
+        level.averages.resize((size_t)level.capacity * numBands);
+        level.maxima.resize((size_t)level.capacity * numBands);
+        level.hasData.resize((size_t)level.capacity);
+    }
+
+    clear();
+}
+
+void SpectralHistory::clear()
+{
+    const juce::ScopedLock sl(lock);
+
+    for (auto& level : levels)
+    {
+        level.firstSlot = -1;
+        level.newestSlot = -1;
+        level.currentSlot = -1;
+        level.numAccumulated = 0;
+    }
+
+    ++version;
+}
+
+double SpectralHistory::getMaxSpanSeconds()
+{
+    const auto& coarsest = levelLayouts.back();
+    return coarsest.slotSeconds * coarsest.capacity;
+}
+
+void SpectralHistory::addFrame(const float* bandLevels, double timeSeconds)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto& finest = levels[0];
+    auto slot = (juce::int64)(timeSeconds / finest.slotSeconds);
+
+    if (slot < finest.currentSlot)
+    {
+        //the clock was set back, by more than a second nothing stored lines up with it any more
+        if ((finest.currentSlot - slot) * finest.slotSeconds > 1.0)
+            clear();
+        else
+            slot = finest.currentSlot;
+    }
+
+    //a frame from a later slot closes the current one. the ones skipped in between become gaps when it's stored
+    if (slot != finest.currentSlot && finest.numAccumulated > 0)
+        closeSlot(0);
+
+    finest.currentSlot = slot;
+    accumulate(finest, bandLevels, bandLevels);
+}
+
+void SpectralHistory::accumulate(Level& level, const float* averages, const float* maxima)
+{
+    using FVO = juce::FloatVectorOperations;
+
+    if (level.numAccumulated == 0)
+    {
+        FVO::copy(level.sum.data(), averages, numBands);
+        FVO::copy(level.max.data(), maxima, numBands);
+    }
+    else
+    {
+        FVO::add(level.sum.data(), averages, numBands);
+        FVO::max(level.max.data(), level.max.data(), maxima, numBands);
+    }
+
+    ++level.numAccumulated;
+}
+
+void SpectralHistory::closeSlot(int levelIndex)
+{
+    auto& level = levels[levelIndex];
+    const auto slot = level.currentSlot;
+
+    //the slots since the last stored one got nothing. past a whole ring's worth, all of it is a gap
+    if (level.firstSlot < 0)
+        level.firstSlot = slot;
+    else
+        for (auto gap = juce::jmax(level.newestSlot + 1, slot - level.capacity + 1); gap < slot; ++gap)
+            level.hasData[(size_t)(gap % level.capacity)] = false;
+
+    level.newestSlot = slot;
+
+    const auto index = (size_t)(slot % level.capacity);
+    level.hasData[index] = true;
+
+    auto* average = level.averages.data() + index * numBands;
+    auto* maximum = level.maxima.data() + index * numBands;
+
+    juce::FloatVectorOperations::copyWithMultiply(average, level.sum.data(), 1.f / (float)level.numAccumulated, numBands);
+    juce::FloatVectorOperations::copy(maximum, level.max.data(), numBands);
+    level.numAccumulated = 0;
+
+    if (levelIndex == 0)
+        ++version;
+
+    //every slot is worth the same in the level above, whatever number of frames went into it.
+    //the gaps aren't handed up, the parent averages over the slots that have something
+    if (levelIndex + 1 < numLevels)
+    {
+        auto& parent = levels[levelIndex + 1];
+        const auto parentSlot = slot / parent.childrenPerSlot;
+
+        if (parentSlot != parent.currentSlot && parent.numAccumulated > 0)
+            closeSlot(levelIndex + 1);
+
+        parent.currentSlot = parentSlot;
+        accumulate(parent, average, maximum);
+
+        //it can't get any more, no need to wait for a later slot to close it
+        if (parent.numAccumulated == parent.childrenPerSlot)
+            closeSlot(levelIndex + 1);
+    }
+}
+
+void SpectralHistory::read(double spanSeconds, double nowSeconds, int numRows, float* averages, float* maxima) const
+{
+    using FVO = juce::FloatVectorOperations;
+
+    if (numRows <= 0)
+        return;
+
+    const juce::ScopedLock sl(lock);
+
+    //the finest level that reaches back far enough, or the coarsest one
+    int levelIndex = 0;
+    while (levelIndex + 1 < numLevels && levels[levelIndex].slotSeconds * levels[levelIndex].capacity < spanSeconds)
+        ++levelIndex;
+
+    const auto& level = levels[levelIndex];
+    const auto slotsPerRow = spanSeconds / level.slotSeconds / numRows;
+
+    //the slot 'now' falls into is still being built, the rows start with the one before it
+    const auto newestSlot = (juce::int64)(nowSeconds / level.slotSeconds) - 1;
+
+    for (int row = 0; row < numRows; ++row)
+    {
+        auto* rowAverages = averages + (size_t)row * numBands;
+        auto* rowMaxima = maxima + (size_t)row * numBands;
+
+        //slots [first, end) back from the newest one
+        const auto first = (int)(row * slotsPerRow);
+        const auto end = juce::jmax(first + 1, (int)((row + 1) * slotsPerRow));
+
+        int numRecorded = 0;
+
+        for (int back = first; back < end; ++back)
+        {
+            const auto slot = newestSlot - back;
+
+            if (!level.isRecorded(slot))
+                continue;
+
+            const auto index = (size_t)(slot % level.capacity);
+            const auto* slotAverages = level.averages.data() + index * numBands;
+            const auto* slotMaxima = level.maxima.data() + index * numBands;
+
+            if (numRecorded++ == 0)
+            {
+                FVO::copy(rowAverages, slotAverages, numBands);
+                FVO::copy(rowMaxima, slotMaxima, numBands);
+            }
+            else
+            {
+                FVO::add(rowAverages, slotAverages, numBands);
+                FVO::max(rowMaxima, rowMaxima, slotMaxima, numBands);
+            }
+        }
+
+        //a row that's partly a gap is the average of what was recorded
+        if (numRecorded == 0)
+        {
+            FVO::fill(rowAverages, noData, numBands);
+            FVO::fill(rowMaxima, noData, numBands);
+        }
+        else
+        {
+            FVO::multiply(rowAverages, 1.f / (float)numRecorded, numBands);
+        }
+    }
+}
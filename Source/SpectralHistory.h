@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    SpectralHistory.h
+
+    Hours of analyzer history in constant memory: a pyramid of fixed-size
+    rings, each level averaging the one below over a longer slot.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ long-term average and maximum per frequency band, kept as a pyramid of rings:
+   level 0: 0.1 s slots, the last minute
+   level 1: 1 s slots, the last 15 minutes
+   level 2: 10 s slots, the last 90 minutes
+   level 3: 60 s slots, the last 24 hours
+ slots are wall clock time: slot n of a level covers [n, n + 1) * its slot length since the epoch,
+ so every level lines up with the one below. frames are accumulated into the current level 0 slot.
+ a closed slot is handed up to the next level, which closes once all of its slots are in or a later
+ one arrives, so building it costs O(bands) per frame plus rarely a little more.
+ slots nothing was recorded in are kept as gaps, so stretches without frames show up as such
+ instead of the rows around them closing ranks. memory is fixed at construction, ~1.7 MB.
+ one writer thread; read() may run on another one, the two take turns on a lock.
+ */
+struct SpectralHistory
+{
+    //1/6 octave bands between 20 Hz and 20 kHz, spaced like the analyzer's x axis
+    static constexpr int numBands = 60;
+    static constexpr int numLevels = 4;
+
+    //what read() returns for rows nothing was recorded in, before the history starts or while there were no frames
+    static constexpr float noData = -std::numeric_limits<float>::infinity();
+
+    SpectralHistory();
+
+    //wall clock time in seconds, what the frames are stamped with and read() counts back from
+    static double getCurrentTime() { return juce::Time::currentTimeMillis() * 0.001; }
+
+    /**
+     adds one frame of numBands levels in dB, taken at 'timeSeconds' (getCurrentTime()).
+     if the clock is set back by more than a second the history starts over, smaller steps count
+     towards the current slot.
+     */
+    void addFrame(const float* bandLevels, double timeSeconds);
+
+    /**
+     'numRows' rows of numBands averages and maxima covering the 'spanSeconds' before 'nowSeconds', newest row first.
+     reads from the finest level that covers the span, so the cost is O(span / slot length + numRows * numBands).
+     rows without a single recorded slot come out as noData.
+     */
+    void read(double spanSeconds, double nowSeconds, int numRows, float* averages, float* maxima) const;
+
+    //goes up whenever a level 0 slot is closed, i.e. whenever read() could return something new
+    juce::uint32 getVersion() const { return version.load(); }
+
+    //longest span that can be read
+    static double getMaxSpanSeconds();
+
+    void clear();
+private:
+    struct Level
+    {
+        double slotSeconds = 0.0;
+        int capacity = 0;
+        //how many slots of the level below make one of this level's
+        int childrenPerSlot = 0;
+
+        //capacity x numBands, ring of closed slots. slot n lives at n % capacity
+        std::vector<float> averages, maxima;
+        //false for the gaps
+        std::vector<bool> hasData;
+        //the oldest and newest slot stored, gaps included. -1 while nothing is
+        juce::int64 firstSlot = -1;
+        juce::int64 newestSlot = -1;
+
+        //the slot being built
+        juce::int64 currentSlot = -1;
+        std::array<float, numBands> sum, max;
+        int numAccumulated = 0;
+
+        bool isRecorded(juce::int64 slot) const
+        {
+            return firstSlot >= 0 && slot >= firstSlot && slot <= newestSlot && slot > newestSlot - capacity
+                && hasData[(size_t)(slot % capacity)];
+        }
+    };
+
+    std::array<Level, numLevels> levels;
+    std::atomic<juce::uint32> version { 0 };
+
+    juce::CriticalSection lock;
+
+    void accumulate(Level& level, const float* averages, const float* maxima);
+    void closeSlot(int levelIndex);
+};
@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+    SpectrumRecorder.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumRecorder.h"
+
+SpectrumRecorder::SpectrumRecorder() : juce::Thread("Spectrum Recorder")
+{
+}
+
+SpectrumRecorder::~SpectrumRecorder()
+{
+    accepting.store(false);
+    stopThread(4000);
+}
+
+bool SpectrumRecorder::start(const juce::File& newFile, bool quantiseToFloat16)
+{
+    if (isThreadRunning())
+        return false;
+
+    //allocated on first use, so editors that never record don't carry the queue around
+    if (slotSamples.empty())
+    {
+        slotSamples.resize((size_t)queueSize * 2 * maxBins);
+        halfScratch.resize((size_t)2 * maxBins);
+    }
+
+    file = newFile;
+    useFloat16 = quantiseToFloat16;
+    recordedNumBins = 0;
+    startTimeMs = juce::Time::getMillisecondCounterHiRes();
+    startWallClockMs = juce::Time::currentTimeMillis();
+
+    numDroppedFrames.store(0);
+    failedToOpen.store(false);
+    accepting.store(true);
+
+    //below the analyzer workers, nothing waits for it
+    startThread(3);
+    return true;
+}
+
+void SpectrumRecorder::stop()
+{
+    accepting.store(false);
+    notify();
+}
+
+void SpectrumRecorder::pushFrame(const float* left, const float* right, int numBins, int band, double sampleRate)
+{
+    if (!accepting.load())
+        return;
+
+    int start1, size1, start2, size2;
+    queue.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 == 0 || numBins > maxBins)
+    {
+        numDroppedFrames.fetch_add(1);
+        return;
+    }
+
+    auto& slot = slots[start1];
+    slot.timeMs = juce::Time::getMillisecondCounterHiRes();
+    slot.sampleRate = sampleRate;
+    slot.numBins = numBins;
+    slot.band = band;
+
+    auto* samples = slotSamples.data() + (size_t)start1 * 2 * maxBins;
+    juce::FloatVectorOperations::copy(samples, left, numBins);
+    juce::FloatVectorOperations::copy(samples + numBins, right, numBins);
+
+    queue.finishedWrite(1);
+}
+
+void SpectrumRecorder::run()
+{
+    juce::FileOutputStream stream(file);
+
+    if (stream.failedToOpen())
+    {
+        accepting.store(false);
+        failedToOpen.store(true);
+        return;
+    }
+
+    stream.setPosition(0);
+    stream.truncate();
+
+    for (;;)
+    {
+        //checked before draining, so whatever was pushed up to stop() still ends up in the file
+        const auto finishing = !accepting.load() || threadShouldExit();
+
+        writePendingFrames(stream);
+
+        if (finishing)
+            break;
+
+        wait(50);
+    }
+
+    stream.flush();
+}
+
+void SpectrumRecorder::writePendingFrames(juce::OutputStream& stream)
+{
+    int start1, size1, start2, size2;
+    queue.prepareToRead(queue.getNumReady(), start1, size1, start2, size2);
+
+    auto writeSlot = [this, &stream](int index)
+    {
+        const auto& slot = slots[index];
+
+        //left over from before this recording started
+        if (slot.timeMs < startTimeMs)
+            return;
+
+        if (recordedNumBins == 0)
+        {
+            recordedNumBins = slot.numBins;
+            writeHeader(stream, slot);
+        }
+
+        if (slot.numBins != recordedNumBins)
+        {
+            numDroppedFrames.fetch_add(1);
+            return;
+        }
+
+        stream.writeInt64((juce::int64)((slot.timeMs - startTimeMs) * 1000.0));
+        stream.writeInt(slot.band);
+        stream.writeInt(0);
+
+        //samples go out in host order, which is little-endian everywhere this plugin builds
+        const auto* samples = slotSamples.data() + (size_t)index * 2 * maxBins;
+        const auto numSamples = 2 * slot.numBins;
+
+        if (useFloat16)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                halfScratch[i] = toFloat16(samples[i]);
+
+            stream.write(halfScratch.data(), (size_t)numSamples * sizeof(juce::uint16));
+        }
+        else
+        {
+            stream.write(samples, (size_t)numSamples * sizeof(float));
+        }
+    };
+
+    for (int i = 0; i < size1; ++i)
+        writeSlot(start1 + i);
+
+    for (int i = 0; i < size2; ++i)
+        writeSlot(start2 + i);
+
+    queue.finishedRead(size1 + size2);
+}
+
+void SpectrumRecorder::writeHeader(juce::OutputStream& stream, const Slot& first)
+{
+    const auto bytesPerSample = useFloat16 ? 2 : 4;
+    const auto recordSize = recordHeaderSize + 2 * first.numBins * bytesPerSample;
+
+    int fftOrder = 0;
+    while ((1 << fftOrder) < 2 * first.numBins)
+        ++fftOrder;
+
+    const char magic[8] = "PEQSPEC";
+    stream.write(magic, sizeof(magic));
+    stream.writeInt(1);
+    stream.writeInt(first.numBins);
+    stream.writeInt(2);
+    stream.writeInt(bytesPerSample);
+    stream.writeDouble(first.sampleRate * (1 << first.band));
+    stream.writeInt64(startWallClockMs);
+    stream.writeInt(recordSize);
+    stream.writeInt(fftOrder);
+
+    //pad to headerSize, so the records start 8-byte aligned
+    const char padding[headerSize - 48] = {};
+    stream.write(padding, sizeof(padding));
+}
+
+juce::uint16 SpectrumRecorder::toFloat16(float value)
+{
+    juce::uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const auto sign = (juce::uint32)((bits >> 16) & 0x8000);
+    const auto biasedExponent = (int)((bits >> 23) & 0xff);
+    auto mantissa = bits & 0x7fffff;
+
+    //infinities stay infinite, NaNs stay NaNs
+    if (biasedExponent == 0xff)
+        return (juce::uint16)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+
+    const auto exponent = biasedExponent - 127 + 15;
+
+    if (exponent >= 31)
+        return (juce::uint16)(sign | 0x7c00);
+
+    //too small for a normal half: shift into a subnormal, or flush to zero
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return (juce::uint16)sign;
+
+        mantissa |= 0x800000;
+        const auto shift = (juce::uint32)(14 - exponent);
+        auto half = mantissa >> shift;
+        const auto remainder = mantissa & ((1u << shift) - 1);
+        const auto halfway = 1u << (shift - 1);
+
+        if (remainder > halfway || (remainder == halfway && (half & 1) != 0))
+            ++half;
+
+        return (juce::uint16)(sign | half);
+    }
+
+    //round to nearest even. a carry out of the mantissa correctly bumps the exponent, up to infinity.
+    auto half = ((juce::uint32)exponent << 10) | (mantissa >> 13);
+    const auto remainder = mantissa & 0x1fff;
+
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0))
+        ++half;
+
+    return (juce::uint16)(sign | half);
+}
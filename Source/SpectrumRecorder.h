@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    SpectrumRecorder.h
+
+    Logs analyzer frames to a binary file for offline inspection, with all
+    disk access on a thread of its own.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ records analyzer frames to a flat binary file. the analyzer hands frames over through a
+ preallocated lock-free queue and a writer thread does all the file work, so neither the
+ analyzer nor the message thread ever waits for the disk. frames that don't fit into the
+ queue are dropped and counted.
+
+ the file is made to be memory-mapped: a 64 byte header, then fixed-size records.
+   header:  char[8] "PEQSPEC", int32 version, int32 numBins, int32 numChannels (2),
+            int32 bytesPerSample (4 = float32, 2 = float16), float64 sampleRate of band 0,
+            int64 start time (ms since 1970), int32 recordSize, int32 fftOrder, zero padding
+   record:  int64 microseconds since the start, int32 band, int32 padding,
+            numBins left channel dB values, then numBins right channel ones
+ band b runs at sampleRate / 2^b. everything is little-endian, the number of records is
+ (fileSize - 64) / recordSize.
+ */
+struct SpectrumRecorder : private juce::Thread
+{
+    //the analyzer's largest FFT is 8192 points
+    static constexpr int maxBins = 4096;
+    static constexpr int headerSize = 64;
+    static constexpr int recordHeaderSize = 16;
+
+    SpectrumRecorder();
+    ~SpectrumRecorder() override;
+
+    /**
+     message thread. the file is opened and the header written on the writer thread.
+     returns false if the previous recording is still being finished off.
+     */
+    bool start(const juce::File& file, bool quantiseToFloat16);
+
+    /**
+     message thread. doesn't wait, the writer drains what's queued and closes the file on its own.
+     */
+    void stop();
+
+    bool isRecording() const { return accepting.load(); }
+    //frames of the current (or last) recording that didn't make it into the file
+    juce::int64 getNumDroppedFrames() const { return numDroppedFrames.load(); }
+
+    /**
+     message thread. true once after the writer couldn't open the file of the last start(),
+     the recording has stopped by then.
+     */
+    bool checkOpenFailure() { return failedToOpen.exchange(false); }
+
+    /**
+     analyzer thread. never blocks. the first frame fixes the number of bins, frames with
+     another count (after a resolution change) are dropped.
+     */
+    void pushFrame(const float* left, const float* right, int numBins, int band, double sampleRate);
+private:
+    static constexpr int queueSize = 32;
+
+    struct Slot
+    {
+        double timeMs = 0.0;
+        double sampleRate = 0.0;
+        int numBins = 0;
+        int band = 0;
+    };
+
+    //slot i's samples are at i * 2 * maxBins, left then right
+    std::vector<float> slotSamples;
+    std::array<Slot, queueSize> slots;
+    juce::AbstractFifo queue { queueSize };
+
+    std::atomic<bool> accepting { false };
+    std::atomic<juce::int64> numDroppedFrames { 0 };
+    std::atomic<bool> failedToOpen { false };
+
+    //only touched while the writer isn't running, or by the writer itself
+    juce::File file;
+    bool useFloat16 = false;
+    double startTimeMs = 0.0;
+    juce::int64 startWallClockMs = 0;
+    int recordedNumBins = 0;
+    std::vector<juce::uint16> halfScratch;
+
+    void run() override;
+    void writePendingFrames(juce::OutputStream& stream);
+    void writeHeader(juce::OutputStream& stream, const Slot& first);
+
+    static juce::uint16 toFloat16(float value);
+};